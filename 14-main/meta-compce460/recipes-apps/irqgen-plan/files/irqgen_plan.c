@@ -0,0 +1,562 @@
+/**
+ * @file   irqgen_plan.c
+ * @date   17 October 2026
+ * @target_device Xilinx PYNQ-Z1
+ * @brief   Discrete-event model of the IRQ Generator, the irqgen handler,
+ *          the latencies buffer and its reader, to size a deployment
+ *          before running it on a board.
+ *
+ * usage: irqgen-plan -g line:amount:delay[@start_us] ... [options]
+ *
+ *   -g  a generation command, as written to /sys/kernel/irqgen (repeatable)
+ *   -h  handler service time in ns (1500), or a file to calibrate it from
+ *   -c  reader service time per sample in ns (5000), or a file
+ *   -w  reader wakeup delay in ns (20000)
+ *   -N  capacity of the latencies buffer, MAX_LATENCIES (10000)
+ *   -t  wakeup_threshold (1)
+ *   -r  runs with different seeds (1)
+ *   -s  random seed (1)
+ *
+ * Calibration files hold one value per line. For -h, a CSV capture of
+ * /dev/irqgen taken in ping-pong mode (/sys/kernel/irqgen/pingpong) is
+ * accepted as is: without queueing, the latency column is the time the
+ * IRQ spends up to its ack. For -c, each value is the ns a reader spent
+ * on one sample, e.g. the deltas between the read() calls of a collector.
+ * The service times are then drawn from the values read.
+ *
+ * The model:
+ * - the IRQ Generator schedules the IRQ k of a command at start + k *
+ *   delay FPGA cycles, but asserts it only once the previous IRQ of its
+ *   line was acked: its latency is counted from the schedule, so it
+ *   includes the queueing behind the previous IRQ, as on the board;
+ * - a single CPU runs the handlers in the order the IRQs were asserted,
+ *   and the sample is pushed when the handler ends;
+ * - the buffer holds at most N - 1 unread samples: a push on a full
+ *   buffer evicts the oldest unread sample, as irqgen_data_push_latency();
+ * - a sleeping reader is woken once wakeup_threshold samples are pending,
+ *   then reads one sample at a time until the buffer is empty.
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define FPGA_CLOCK_NS 10            // 1000 / FPGA_CLOCK_MHZ, as irqgen.h
+#define IRQGEN_MAX_LINES 16         // 4 bits of the GENIRQ register
+#define IRQGEN_MAX_AMOUNT 0xFFF     // 12 bits of the GENIRQ register
+#define IRQGEN_MAX_DELAY 0x3FFF     // 14 bits of the GENIRQ register
+#define MAX_CMDS 64
+
+/*-
+ * A generation command
+ *
+ * @line: the IRQ line
+ * @amount: IRQs to generate
+ * @delay: IRQ delay, in FPGA clock cycles
+ * @start: time in ns when the command is written
+ */
+struct plan_cmd {
+    int line;
+    uint32_t amount;
+    uint32_t delay;
+    uint64_t start;
+};
+
+/*-
+ * Service time: a constant, or values drawn from a calibration
+ *
+ * @fixed: the constant in ns, used if @count is 0
+ * @values: calibration values in ns
+ * @count: number of @values
+ */
+struct plan_dist {
+    uint64_t fixed;
+    uint64_t *values;
+    size_t count;
+};
+
+/*-
+ * Growable array of ns values, for the percentiles
+ */
+struct plan_vec {
+    uint64_t *v;
+    size_t len;
+    size_t cap;
+};
+
+enum plan_ev_type {
+    EV_SCHED = 0,                   // an IRQ is due on a line
+    EV_HANDLED,                     // the running handler ends
+    EV_WAKE,                        // the reader starts running
+    EV_READ,                        // the reader is done with a sample
+};
+
+/*-
+ * An event of the simulation
+ *
+ * @t: time in ns
+ * @seq: insertion order, to break ties deterministically
+ * @type: one of enum plan_ev_type
+ * @line: the IRQ line of EV_SCHED
+ */
+struct plan_ev {
+    uint64_t t;
+    uint64_t seq;
+    int type;
+    int line;
+};
+
+/*-
+ * State of an IRQ line
+ *
+ * @cmd: index of the command in progress, -1 if none
+ * @next: index within the command of the next IRQ to schedule
+ * @sched: schedule in ns of the IRQ asserted on the line
+ */
+struct plan_line {
+    int cmd;
+    uint32_t next;
+    uint64_t sched;
+};
+
+/*-
+ * A sample in the latencies buffer
+ *
+ * @timestamp: time in ns when its handler started
+ */
+struct plan_sample {
+    uint64_t timestamp;
+};
+
+struct plan {
+    struct plan_cmd cmds[MAX_CMDS];
+    int ncmds;
+    struct plan_dist handler;
+    struct plan_dist reader;
+    uint64_t wake_ns;
+    uint32_t capacity;
+    uint32_t threshold;
+    uint64_t rng;
+
+    struct plan_ev *heap;
+    size_t nev, evcap;
+    uint64_t evseq;
+
+    struct plan_line lines[IRQGEN_MAX_LINES];
+    int cmd_next[IRQGEN_MAX_LINES];     // next command to start per line
+    int runq[IRQGEN_MAX_LINES];         // asserted IRQs, by line, FIFO
+    int runq_len;
+    int handler_line;                   // line in the handler, -1 if idle
+    uint64_t handler_start;
+
+    struct plan_sample *ring;
+    uint32_t wp, rp;
+    int reader_state;                   // 0 asleep, 1 waking, 2 reading
+    uint32_t max_pending;
+
+    uint64_t handled;
+    uint64_t dropped;
+    uint64_t consumed;
+    uint64_t end;
+    struct plan_vec irq_latency;
+    struct plan_vec e2e_latency;
+};
+
+/* ---- helpers ---- */
+
+static uint64_t plan_rand(struct plan *p)
+{
+    // xorshift64*
+    p->rng ^= p->rng >> 12;
+    p->rng ^= p->rng << 25;
+    p->rng ^= p->rng >> 27;
+    return p->rng * 0x2545F4914F6CDD1DULL;
+}
+
+static uint64_t plan_draw(struct plan *p, const struct plan_dist *d)
+{
+    if (0 == d->count)
+        return d->fixed;
+    return d->values[plan_rand(p) % d->count];
+}
+
+static void vec_push(struct plan_vec *v, uint64_t x)
+{
+    if (v->len == v->cap) {
+        v->cap = v->cap ? v->cap * 2 : 1024;
+        v->v = realloc(v->v, v->cap * sizeof(*v->v));
+        if (!v->v) {
+            perror("realloc");
+            exit(1);
+        }
+    }
+    v->v[v->len++] = x;
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+static uint64_t vec_pct(const struct plan_vec *v, double pct)
+{
+    size_t i;
+
+    if (0 == v->len)
+        return 0;
+    i = (size_t)(pct / 100.0 * (v->len - 1) + 0.5);
+    return v->v[i];
+}
+
+/* ---- event queue: binary min-heap on (t, seq) ---- */
+
+static int ev_before(const struct plan_ev *a, const struct plan_ev *b)
+{
+    return a->t < b->t || (a->t == b->t && a->seq < b->seq);
+}
+
+static void ev_push(struct plan *p, uint64_t t, int type, int line)
+{
+    size_t i;
+
+    if (p->nev == p->evcap) {
+        p->evcap = p->evcap ? p->evcap * 2 : 64;
+        p->heap = realloc(p->heap, p->evcap * sizeof(*p->heap));
+        if (!p->heap) {
+            perror("realloc");
+            exit(1);
+        }
+    }
+
+    i = p->nev++;
+    p->heap[i] = (struct plan_ev){ .t = t, .seq = p->evseq++, .type = type, .line = line };
+    while (i > 0 && ev_before(&p->heap[i], &p->heap[(i - 1) / 2])) {
+        struct plan_ev tmp = p->heap[i];
+
+        p->heap[i] = p->heap[(i - 1) / 2];
+        p->heap[(i - 1) / 2] = tmp;
+        i = (i - 1) / 2;
+    }
+}
+
+static struct plan_ev ev_pop(struct plan *p)
+{
+    struct plan_ev top = p->heap[0];
+    size_t i = 0;
+
+    p->heap[0] = p->heap[--p->nev];
+    for (;;) {
+        size_t l = 2 * i + 1, r = l + 1, m = i;
+        struct plan_ev tmp;
+
+        if (l < p->nev && ev_before(&p->heap[l], &p->heap[m]))
+            m = l;
+        if (r < p->nev && ev_before(&p->heap[r], &p->heap[m]))
+            m = r;
+        if (m == i)
+            break;
+        tmp = p->heap[i];
+        p->heap[i] = p->heap[m];
+        p->heap[m] = tmp;
+        i = m;
+    }
+
+    return top;
+}
+
+/* ---- model ---- */
+
+static uint32_t ring_pending(const struct plan *p)
+{
+    return (p->wp - p->rp + p->capacity) % p->capacity;
+}
+
+// Start the next command of a line, if any: a new command supersedes the
+// one in progress on the board, here the commands of a line run in turn
+static void line_next_cmd(struct plan *p, int line, uint64_t now)
+{
+    struct plan_line *l = &p->lines[line];
+    int c;
+
+    l->cmd = -1;
+    for (c = p->cmd_next[line]; c < p->ncmds; ++c) {
+        if (p->cmds[c].line != line)
+            continue;
+        p->cmd_next[line] = c + 1;
+        l->cmd = c;
+        l->next = 0;
+        ev_push(p, p->cmds[c].start > now ? p->cmds[c].start : now, EV_SCHED, line);
+        return;
+    }
+    p->cmd_next[line] = p->ncmds;
+}
+
+static void handler_start(struct plan *p, uint64_t now)
+{
+    if (p->handler_line >= 0 || 0 == p->runq_len)
+        return;
+
+    p->handler_line = p->runq[0];
+    memmove(p->runq, p->runq + 1, --p->runq_len * sizeof(*p->runq));
+    p->handler_start = now;
+    ev_push(p, now + plan_draw(p, &p->handler), EV_HANDLED, p->handler_line);
+}
+
+// Time in ns when the IRQ of a line is due, at the earliest now: the
+// previous one may have been acked after its schedule
+static uint64_t line_due(const struct plan *p, int line, uint64_t now)
+{
+    const struct plan_line *l = &p->lines[line];
+    const struct plan_cmd *c = &p->cmds[l->cmd];
+    uint64_t t = c->start + (uint64_t)l->next * c->delay * FPGA_CLOCK_NS;
+
+    return t > now ? t : now;
+}
+
+// The IRQ is asserted: its latency runs from its schedule, so that it
+// includes the wait for the ack of the previous one
+static void on_sched(struct plan *p, int line, uint64_t now)
+{
+    struct plan_line *l = &p->lines[line];
+    const struct plan_cmd *c = &p->cmds[l->cmd];
+
+    l->sched = c->start + (uint64_t)l->next * c->delay * FPGA_CLOCK_NS;
+    ++l->next;
+    p->runq[p->runq_len++] = line;
+    handler_start(p, now);
+}
+
+static void reader_read(struct plan *p, uint64_t now)
+{
+    if (p->rp == p->wp) {
+        p->reader_state = 0;
+        return;
+    }
+
+    vec_push(&p->e2e_latency, now - p->ring[p->rp].timestamp);
+    p->rp = (p->rp + 1) % p->capacity;
+    ++p->consumed;
+    p->reader_state = 2;
+    ev_push(p, now + plan_draw(p, &p->reader), EV_READ, -1);
+}
+
+static void on_handled(struct plan *p, int line, uint64_t now)
+{
+    struct plan_line *l = &p->lines[line];
+    const struct plan_cmd *c = &p->cmds[l->cmd];
+    uint32_t pending;
+
+    ++p->handled;
+    vec_push(&p->irq_latency, now - l->sched);
+
+    // Push with the overflow semantics of irqgen_data_push_latency()
+    p->ring[p->wp].timestamp = p->handler_start;
+    p->wp = (p->wp + 1) % p->capacity;
+    if (p->wp == p->rp) {
+        ++p->dropped;
+        p->rp = (p->rp + 1) % p->capacity;
+    }
+    pending = ring_pending(p);
+    if (pending > p->max_pending)
+        p->max_pending = pending;
+    if (0 == p->reader_state && pending >= p->threshold) {
+        p->reader_state = 1;
+        ev_push(p, now + p->wake_ns, EV_WAKE, -1);
+    }
+
+    // The ack frees the line for its next IRQ
+    if (l->next < c->amount)
+        ev_push(p, line_due(p, line, now), EV_SCHED, line);
+    else
+        line_next_cmd(p, line, now);
+
+    p->handler_line = -1;
+    handler_start(p, now);
+}
+
+static void plan_run(struct plan *p)
+{
+    int line;
+
+    p->ring = calloc(p->capacity, sizeof(*p->ring));
+    if (!p->ring) {
+        perror("calloc");
+        exit(1);
+    }
+    p->handler_line = -1;
+    for (line = 0; line < IRQGEN_MAX_LINES; ++line)
+        line_next_cmd(p, line, 0);
+
+    while (p->nev > 0) {
+        struct plan_ev e = ev_pop(p);
+
+        p->end = e.t;
+        switch (e.type) {
+        case EV_SCHED:
+            on_sched(p, e.line, e.t);
+            break;
+        case EV_HANDLED:
+            on_handled(p, e.line, e.t);
+            break;
+        case EV_WAKE:
+        case EV_READ:
+            reader_read(p, e.t);
+            break;
+        }
+    }
+}
+
+/* ---- setup ---- */
+
+static int parse_cmd(struct plan *p, const char *arg)
+{
+    struct plan_cmd *c;
+    unsigned int line, amount, delay;
+    double start_us = 0;
+
+    if (p->ncmds == MAX_CMDS)
+        return -ENOSPC;
+    if (sscanf(arg, "%u:%u:%u@%lf", &line, &amount, &delay, &start_us) < 3)
+        return -EINVAL;
+    if (line >= IRQGEN_MAX_LINES || 0 == amount || amount > IRQGEN_MAX_AMOUNT ||
+        delay > IRQGEN_MAX_DELAY || start_us < 0)
+        return -ERANGE;
+
+    c = &p->cmds[p->ncmds++];
+    c->line = line;
+    c->amount = amount;
+    c->delay = delay;
+    c->start = (uint64_t)(start_us * 1000);
+    return 0;
+}
+
+/*
+ * A constant in ns, or a file of values in ns, one per line. A CSV line
+ * of /dev/irqgen ("line,latency,...") contributes its latency in cycles.
+ */
+static int parse_dist(struct plan_dist *d, const char *arg)
+{
+    char *end, buf[256];
+    unsigned long long v;
+    size_t cap = 0;
+    FILE *f;
+
+    v = strtoull(arg, &end, 0);
+    if (end != arg && '\0' == *end) {
+        d->fixed = v;
+        return 0;
+    }
+
+    f = fopen(arg, "r");
+    if (!f)
+        return -errno;
+    while (fgets(buf, sizeof(buf), f)) {
+        unsigned int line;
+        unsigned long long latency;
+
+        if (2 == sscanf(buf, "%u,%llu,", &line, &latency))
+            v = latency * FPGA_CLOCK_NS;
+        else if (1 != sscanf(buf, "%llu", &v))
+            continue;
+        if (d->count == cap) {
+            cap = cap ? cap * 2 : 1024;
+            d->values = realloc(d->values, cap * sizeof(*d->values));
+            if (!d->values) {
+                fclose(f);
+                return -ENOMEM;
+            }
+        }
+        d->values[d->count++] = v;
+    }
+    fclose(f);
+
+    return 0 == d->count ? -ENODATA : 0;
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr, "usage: %s -g line:amount:delay[@start_us] ... [-h ns|file] [-c ns|file]\n"
+            "       [-w ns] [-N capacity] [-t threshold] [-r runs] [-s seed]\n", argv0);
+}
+
+static void report(struct plan *p, int run)
+{
+    qsort(p->irq_latency.v, p->irq_latency.len, sizeof(uint64_t), cmp_u64);
+    qsort(p->e2e_latency.v, p->e2e_latency.len, sizeof(uint64_t), cmp_u64);
+
+    printf("run %d: %.3f ms simulated\n", run, p->end / 1e6);
+    printf("  handled %llu, consumed %llu, dropped %llu (%.2f%%), max pending %u/%u\n",
+           (unsigned long long)p->handled, (unsigned long long)p->consumed,
+           (unsigned long long)p->dropped,
+           p->handled ? 100.0 * p->dropped / p->handled : 0.0,
+           p->max_pending, p->capacity - 1);
+    printf("  IRQ latency ns: p50 %llu p99 %llu max %llu\n",
+           (unsigned long long)vec_pct(&p->irq_latency, 50),
+           (unsigned long long)vec_pct(&p->irq_latency, 99),
+           (unsigned long long)vec_pct(&p->irq_latency, 100));
+    printf("  end-to-end ns:  p50 %llu p99 %llu max %llu\n",
+           (unsigned long long)vec_pct(&p->e2e_latency, 50),
+           (unsigned long long)vec_pct(&p->e2e_latency, 99),
+           (unsigned long long)vec_pct(&p->e2e_latency, 100));
+}
+
+int main(int argc, char **argv)
+{
+    struct plan cfg = {
+        .handler = { .fixed = 1500 },
+        .reader = { .fixed = 5000 },
+        .wake_ns = 20000,
+        .capacity = 10000,
+        .threshold = 1,
+    };
+    unsigned long long seed = 1;
+    long runs = 1, r;
+    int opt, ret;
+
+    while ((opt = getopt(argc, argv, "g:h:c:w:N:t:r:s:")) != -1) {
+        switch (opt) {
+        case 'g': ret = parse_cmd(&cfg, optarg); break;
+        case 'h': ret = parse_dist(&cfg.handler, optarg); break;
+        case 'c': ret = parse_dist(&cfg.reader, optarg); break;
+        case 'w': cfg.wake_ns = strtoull(optarg, NULL, 0); ret = 0; break;
+        case 'N': cfg.capacity = strtoul(optarg, NULL, 0); ret = 0; break;
+        case 't': cfg.threshold = strtoul(optarg, NULL, 0); ret = 0; break;
+        case 'r': runs = strtol(optarg, NULL, 0); ret = 0; break;
+        case 's': seed = strtoull(optarg, NULL, 0); ret = 0; break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+        if (0 != ret) {
+            fprintf(stderr, "-%c %s: %s\n", opt, optarg, strerror(-ret));
+            return 2;
+        }
+    }
+
+    if (0 == cfg.ncmds || cfg.capacity < 2 || cfg.threshold < 1 ||
+        cfg.threshold > cfg.capacity - 1 || runs < 1) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    for (r = 0; r < runs; ++r) {
+        struct plan p = cfg;
+
+        // xorshift must not start from 0
+        p.rng = (seed + r) * 0x9E3779B97F4A7C15ULL | 1;
+        plan_run(&p);
+        report(&p, r);
+
+        free(p.ring);
+        free(p.heap);
+        free(p.irq_latency.v);
+        free(p.e2e_latency.v);
+    }
+
+    return 0;
+}
@@ -0,0 +1,598 @@
+/**
+ * @file   irqgen_regress.c
+ * @date   17 October 2026
+ * @target_device Xilinx PYNQ-Z1, or any Linux machine with irqgen_emul.ko
+ * @brief   Performance regression suite of irqgen.ko: runs a fixed set of
+ *          scenarios and compares their handler cost, throughput and
+ *          latencies with stored baselines.
+ *
+ * usage: irqgen-regress -b dir [-u] [-r reps] [-a alpha] [-T tolerance %] [scenario...]
+ *
+ *   -b  directory of the baselines, one <scenario>.base file each
+ *   -u  record the baselines instead of comparing with them
+ *   -r  repetitions of each scenario (5)
+ *   -a  significance level of the tests (0.01)
+ *   -T  smallest slowdown reported, in % of the baseline (5)
+ *
+ * Exits with 1 if a metric is significantly worse than its baseline, 2 on
+ * errors. On a machine without the FPGA, build irqgen-mod with IRQGEN_EMUL=y
+ * and load irqgen_emul.ko vtime=1 before irqgen.ko: the latencies are then
+ * counted in virtual time, so only a change of the driver moves them.
+ *
+ * The metrics and their tests:
+ * - handler: mean ns of the handler from the debugfs handler_profile,
+ *   one value per repetition, permutation test on the difference of means;
+ * - throughput: handled IRQs per second from the sample timestamps, one
+ *   value per repetition, permutation test;
+ * - latency: the latencies of all the samples, one-sided Mann-Whitney U
+ *   test.
+ * A metric regresses when its test is significant at alpha and the change
+ * of its mean (median for the latencies) exceeds the tolerance.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <math.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define SYSFS_DIR "/sys/kernel/irqgen"
+#define DEBUGFS_HPROF "/sys/kernel/debug/irqgen/handler_profile"
+#define CHARDEV "/dev/irqgen"
+
+#define MAX_REPS 32
+#define MAX_LATENCY_SAMPLES 4000    // Latencies kept in a baseline
+#define PERMUTATIONS 20000
+#define READ_TIMEOUT_MS 5000
+
+/*-
+ * A scenario: written to SYSFS_DIR/<attr> after enabling the generator
+ *
+ * @name: name of the scenario and of its baseline file
+ * @attr: attribute starting the generation
+ * @cmd: value written to @attr
+ * @line: IRQ line, for the "amount" attribute
+ * @delay: IRQ delay, for the "amount" attribute
+ * @samples: samples expected in /dev/irqgen
+ */
+struct scenario {
+    const char *name;
+    const char *attr;
+    const char *cmd;
+    int line;
+    int delay;
+    int samples;
+};
+
+static const struct scenario scenarios[] = {
+    // Closed loop: the latency of a single IRQ, without queueing
+    { "pingpong",   "pingpong", "0 0 2000", 0, 0,    2000 },
+    // Paced IRQs, the handler keeps up
+    { "paced",      "amount",   "2000",     0, 1000, 2000 },
+    // Back to back IRQs: throughput of the handler
+    { "burst",      "amount",   "4000",     0, 0,    4000 },
+    // Another line, closely paced
+    { "line1",      "amount",   "2000",     1, 200,  2000 },
+};
+#define NSCENARIOS (sizeof(scenarios) / sizeof(scenarios[0]))
+
+/*-
+ * Growable array of values
+ */
+struct vec {
+    double *v;
+    size_t len;
+    size_t cap;
+};
+
+/*-
+ * Metrics of a scenario, over its repetitions
+ */
+struct metrics {
+    struct vec handler;
+    struct vec throughput;
+    struct vec latency;
+};
+
+static void vec_push(struct vec *v, double x)
+{
+    if (v->len == v->cap) {
+        v->cap = v->cap ? v->cap * 2 : 256;
+        v->v = realloc(v->v, v->cap * sizeof(*v->v));
+        if (!v->v) {
+            perror("realloc");
+            exit(2);
+        }
+    }
+    v->v[v->len++] = x;
+}
+
+static void vec_free(struct vec *v)
+{
+    free(v->v);
+    memset(v, 0, sizeof(*v));
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+static double vec_mean(const struct vec *v)
+{
+    double sum = 0;
+    size_t i;
+
+    for (i = 0; i < v->len; ++i)
+        sum += v->v[i];
+    return v->len ? sum / v->len : 0;
+}
+
+static double vec_median(const struct vec *v)
+{
+    double *s, m;
+
+    if (0 == v->len)
+        return 0;
+    s = malloc(v->len * sizeof(*s));
+    if (!s) {
+        perror("malloc");
+        exit(2);
+    }
+    memcpy(s, v->v, v->len * sizeof(*s));
+    qsort(s, v->len, sizeof(*s), cmp_double);
+    m = v->len % 2 ? s[v->len / 2] : (s[v->len / 2 - 1] + s[v->len / 2]) / 2;
+    free(s);
+
+    return m;
+}
+
+/* ---- statistical tests ---- */
+
+static uint64_t rng_state = 0x9E3779B97F4A7C15ULL;
+
+static uint64_t rng_next(void)
+{
+    // xorshift64*, fixed seed: the verdicts are reproducible
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return rng_state * 0x2545F4914F6CDD1DULL;
+}
+
+/*
+ * One-sided permutation test on the difference of the means: p-value of
+ * mean(cur) - mean(base) being at least as large as observed in the
+ * direction `sign` (+1: cur larger is worse, -1: cur smaller is worse)
+ */
+static double permutation_p(const struct vec *base, const struct vec *cur, int sign)
+{
+    size_t n = base->len + cur->len, i, j;
+    double *pool, observed, total = 0;
+    long extreme = 0, k;
+
+    if (0 == base->len || 0 == cur->len)
+        return 1;
+    pool = malloc(n * sizeof(*pool));
+    if (!pool) {
+        perror("malloc");
+        exit(2);
+    }
+    memcpy(pool, base->v, base->len * sizeof(*pool));
+    memcpy(pool + base->len, cur->v, cur->len * sizeof(*pool));
+    for (i = 0; i < n; ++i)
+        total += pool[i];
+    observed = sign * (vec_mean(cur) - vec_mean(base));
+
+    for (k = 0; k < PERMUTATIONS; ++k) {
+        double sum_cur = 0, diff;
+
+        // Partial Fisher-Yates: the first cur->len elements are the sample
+        for (i = 0; i < cur->len; ++i) {
+            double tmp;
+
+            j = i + rng_next() % (n - i);
+            tmp = pool[i];
+            pool[i] = pool[j];
+            pool[j] = tmp;
+            sum_cur += pool[i];
+        }
+        diff = sum_cur / cur->len - (total - sum_cur) / base->len;
+        if (sign * diff >= observed - 1e-12 * fabs(observed))
+            ++extreme;
+    }
+    free(pool);
+
+    return (extreme + 1.0) / (PERMUTATIONS + 1.0);
+}
+
+/*
+ * One-sided Mann-Whitney U test, normal approximation with tie correction:
+ * p-value of cur being stochastically larger than base
+ */
+static double mann_whitney_p(const struct vec *base, const struct vec *cur)
+{
+    size_t n1 = cur->len, n2 = base->len, n = n1 + n2, i, j;
+    struct { double x; int cur; } *all;
+    double rank_cur = 0, ties = 0, u, mean, var, z;
+
+    if (0 == n1 || 0 == n2)
+        return 1;
+    all = malloc(n * sizeof(*all));
+    if (!all) {
+        perror("malloc");
+        exit(2);
+    }
+    for (i = 0; i < n1; ++i) {
+        all[i].x = cur->v[i];
+        all[i].cur = 1;
+    }
+    for (i = 0; i < n2; ++i) {
+        all[n1 + i].x = base->v[i];
+        all[n1 + i].cur = 0;
+    }
+    qsort(all, n, sizeof(*all), cmp_double);
+
+    for (i = 0; i < n; i = j) {
+        double rank, t;
+        size_t k;
+
+        for (j = i + 1; j < n && all[j].x == all[i].x; ++j)
+            ;
+        rank = (i + 1 + j) / 2.0;
+        for (k = i; k < j; ++k)
+            if (all[k].cur)
+                rank_cur += rank;
+        t = j - i;
+        ties += t * t * t - t;
+    }
+    free(all);
+
+    u = rank_cur - n1 * (n1 + 1) / 2.0;
+    mean = n1 * n2 / 2.0;
+    var = n1 * n2 / 12.0 * ((n + 1) - ties / (n * (n - 1.0)));
+    if (var <= 0)
+        return 1;
+    z = (u - mean - 0.5) / sqrt(var);
+
+    return 0.5 * erfc(z / sqrt(2));
+}
+
+/* ---- the driver interfaces ---- */
+
+static int sysfs_write(const char *attr, const char *value)
+{
+    char path[256];
+    ssize_t len = strlen(value);
+    int fd, ret = 0;
+
+    snprintf(path, sizeof(path), SYSFS_DIR "/%s", attr);
+    fd = open(path, O_WRONLY);
+    if (fd < 0)
+        return -errno;
+    if (write(fd, value, len) != len)
+        ret = -errno;
+    close(fd);
+
+    return ret;
+}
+
+static int sysfs_write_int(const char *attr, int value)
+{
+    char buf[32];
+
+    snprintf(buf, sizeof(buf), "%d", value);
+    return sysfs_write(attr, buf);
+}
+
+// Reset the handler profile: -ENOENT without IRQGEN_STATS or debugfs
+static int hprof_reset(void)
+{
+    int fd = open(DEBUGFS_HPROF, O_WRONLY);
+
+    if (fd < 0)
+        return -errno;
+    if (write(fd, "0", 1) != 1) {
+        close(fd);
+        return -errno;
+    }
+    close(fd);
+    return 0;
+}
+
+// Mean ns of the handler over all the CPUs, -1 if unavailable
+static double hprof_mean(void)
+{
+    unsigned long long count, mean, max, total = 0;
+    double sum = 0;
+    char buf[1024];
+    FILE *f;
+    int cpu;
+
+    f = fopen(DEBUGFS_HPROF, "r");
+    if (!f)
+        return -1;
+    while (fgets(buf, sizeof(buf), f)) {
+        if (4 != sscanf(buf, "cpu%d %llu %llu %llu", &cpu, &count, &mean, &max))
+            continue;
+        total += count;
+        sum += (double)count * mean;
+    }
+    fclose(f);
+
+    return total ? sum / total : -1;
+}
+
+// Discard the samples left in /dev/irqgen
+static void drain(int fd)
+{
+    char buf[128];
+
+    while (read(fd, buf, sizeof(buf)) > 0)
+        ;
+}
+
+/*
+ * Run a scenario once, adding its metrics to `m`.
+ * Returns 0 or -errno.
+ */
+static int run_once(const struct scenario *s, struct metrics *m)
+{
+    unsigned long long ts, first = 0, last = 0;
+    unsigned int line, latency;
+    char buf[128];
+    int fd, ret, got = 0;
+    double handler;
+
+    fd = open(CHARDEV, O_RDONLY);
+    if (fd < 0)
+        return -errno;
+    drain(fd);
+    hprof_reset();
+
+    ret = sysfs_write("enabled", "1");
+    if (0 == ret && 0 == strcmp(s->attr, "amount")) {
+        ret = sysfs_write_int("line", s->line);
+        if (0 == ret)
+            ret = sysfs_write_int("delay", s->delay);
+    }
+    if (0 == ret)
+        ret = sysfs_write(s->attr, s->cmd);
+    if (0 != ret)
+        goto end;
+
+    while (got < s->samples) {
+        struct pollfd pfd = { .fd = fd, .events = POLLIN };
+        ssize_t len = read(fd, buf, sizeof(buf) - 1);
+
+        if (len < 0) {
+            ret = -errno;
+            goto end;
+        }
+        if (0 == len) {
+            ret = poll(&pfd, 1, READ_TIMEOUT_MS);
+            if (ret <= 0) {
+                fprintf(stderr, "%s: %d of %d samples before the timeout\n",
+                        s->name, got, s->samples);
+                ret = ret < 0 ? -errno : -ETIMEDOUT;
+                goto end;
+            }
+            continue;
+        }
+        buf[len] = '\0';
+        if (3 != sscanf(buf, "%u,%u,%llu", &line, &latency, &ts))
+            continue;
+        if (0 == got)
+            first = ts;
+        last = ts;
+        ++got;
+        vec_push(&m->latency, latency);
+    }
+    ret = 0;
+
+    if (last > first)
+        vec_push(&m->throughput, (got - 1) * 1e9 / (last - first));
+    handler = hprof_mean();
+    if (handler >= 0)
+        vec_push(&m->handler, handler);
+
+ end:
+    sysfs_write("pingpong", "stop");
+    close(fd);
+    return ret;
+}
+
+/* ---- baselines ---- */
+
+static void write_vec(FILE *f, const char *name, const struct vec *v, size_t max)
+{
+    size_t i, step = v->len > max ? (v->len + max - 1) / max : 1;
+
+    fprintf(f, "%s", name);
+    // Spread the kept latencies evenly over the repetitions
+    for (i = 0; i < v->len; i += step)
+        fprintf(f, " %.3f", v->v[i]);
+    fputc('\n', f);
+}
+
+static int save_baseline(const char *dir, const struct scenario *s, const struct metrics *m)
+{
+    char path[512];
+    FILE *f;
+
+    snprintf(path, sizeof(path), "%s/%s.base", dir, s->name);
+    f = fopen(path, "w");
+    if (!f)
+        return -errno;
+    fprintf(f, "# irqgen-regress baseline v1: %s\n", s->name);
+    write_vec(f, "handler", &m->handler, MAX_REPS);
+    write_vec(f, "throughput", &m->throughput, MAX_REPS);
+    write_vec(f, "latency", &m->latency, MAX_LATENCY_SAMPLES);
+    fclose(f);
+
+    return 0;
+}
+
+static int load_baseline(const char *dir, const struct scenario *s, struct metrics *m)
+{
+    char path[512], *line = NULL;
+    size_t cap = 0;
+    FILE *f;
+
+    snprintf(path, sizeof(path), "%s/%s.base", dir, s->name);
+    f = fopen(path, "r");
+    if (!f)
+        return -errno;
+    while (getline(&line, &cap, f) > 0) {
+        struct vec *v = NULL;
+        char *tok, *save;
+
+        tok = strtok_r(line, " \n", &save);
+        if (!tok || '#' == tok[0])
+            continue;
+        if (0 == strcmp(tok, "handler"))
+            v = &m->handler;
+        else if (0 == strcmp(tok, "throughput"))
+            v = &m->throughput;
+        else if (0 == strcmp(tok, "latency"))
+            v = &m->latency;
+        else
+            continue;
+        while ((tok = strtok_r(NULL, " \n", &save)))
+            vec_push(v, strtod(tok, NULL));
+    }
+    free(line);
+    fclose(f);
+
+    return 0;
+}
+
+/*
+ * Compare a metric with its baseline, `sign` +1 if larger is worse.
+ * Returns 1 on a significant regression.
+ */
+static int compare(const char *scenario, const char *name, const struct vec *base,
+                   const struct vec *cur, int sign, int use_median, double alpha,
+                   double tolerance)
+{
+    double b, c, change, p;
+    int regressed;
+
+    if (0 == base->len || 0 == cur->len) {
+        printf("  %-10s n/a\n", name);
+        return 0;
+    }
+
+    b = use_median ? vec_median(base) : vec_mean(base);
+    c = use_median ? vec_median(cur) : vec_mean(cur);
+    change = b != 0 ? 100.0 * (c - b) / b : 0;
+    if (use_median)
+        p = sign > 0 ? mann_whitney_p(base, cur) : mann_whitney_p(cur, base);
+    else
+        p = permutation_p(base, cur, sign);
+    regressed = p < alpha && sign * change > tolerance;
+
+    printf("  %-10s %12.1f -> %12.1f (%+6.1f%%) p=%.4f%s\n", name, b, c, change, p,
+           regressed ? "  REGRESSION" : "");
+    if (regressed)
+        fprintf(stderr, "%s: %s regressed by %.1f%%\n", scenario, name, sign * change);
+
+    return regressed;
+}
+
+static void usage(const char *argv0)
+{
+    size_t i;
+
+    fprintf(stderr, "usage: %s -b dir [-u] [-r reps] [-a alpha] [-T tolerance %%] [scenario...]\n"
+            "scenarios:", argv0);
+    for (i = 0; i < NSCENARIOS; ++i)
+        fprintf(stderr, " %s", scenarios[i].name);
+    fputc('\n', stderr);
+}
+
+static int selected(const char *name, int argc, char **argv)
+{
+    int i;
+
+    if (0 == argc)
+        return 1;
+    for (i = 0; i < argc; ++i)
+        if (0 == strcmp(name, argv[i]))
+            return 1;
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    const char *dir = NULL;
+    double alpha = 0.01, tolerance = 5;
+    int update = 0, reps = 5, regressions = 0, errors = 0;
+    size_t i;
+    int opt, r;
+
+    while ((opt = getopt(argc, argv, "b:ur:a:T:")) != -1) {
+        switch (opt) {
+        case 'b': dir = optarg; break;
+        case 'u': update = 1; break;
+        case 'r': reps = strtol(optarg, NULL, 0); break;
+        case 'a': alpha = strtod(optarg, NULL); break;
+        case 'T': tolerance = strtod(optarg, NULL); break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (!dir || reps < 1 || reps > MAX_REPS || alpha <= 0 || alpha >= 1) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    for (i = 0; i < NSCENARIOS; ++i) {
+        const struct scenario *s = &scenarios[i];
+        struct metrics cur = { 0 }, base = { 0 };
+        int ret = 0;
+
+        if (!selected(s->name, argc - optind, argv + optind))
+            continue;
+
+        printf("%s:\n", s->name);
+        for (r = 0; r < reps && 0 == ret; ++r)
+            ret = run_once(s, &cur);
+        if (0 == ret)
+            ret = update ? save_baseline(dir, s, &cur) : load_baseline(dir, s, &base);
+
+        if (0 != ret) {
+            fprintf(stderr, "%s: %s\n", s->name, strerror(-ret));
+            ++errors;
+        } else if (update) {
+            printf("  baseline recorded\n");
+        } else {
+            regressions += compare(s->name, "handler", &base.handler, &cur.handler,
+                                   +1, 0, alpha, tolerance);
+            regressions += compare(s->name, "throughput", &base.throughput, &cur.throughput,
+                                   -1, 0, alpha, tolerance);
+            regressions += compare(s->name, "latency", &base.latency, &cur.latency,
+                                   +1, 1, alpha, tolerance);
+        }
+
+        vec_free(&cur.handler);
+        vec_free(&cur.throughput);
+        vec_free(&cur.latency);
+        vec_free(&base.handler);
+        vec_free(&base.throughput);
+        vec_free(&base.latency);
+    }
+
+    if (errors)
+        return 2;
+    return regressions ? 1 : 0;
+}
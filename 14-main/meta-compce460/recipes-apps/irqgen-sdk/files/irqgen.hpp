@@ -0,0 +1,986 @@
+/**
+ * @file   irqgen.hpp
+ * @date   17 October 2026
+ * @target_device Xilinx PYNQ-Z1, or any Linux machine with irqgen_emul.ko
+ * @brief   Header-only C++20 client of irqgen.ko: generation commands, stats
+ *          snapshots and sample streams, each on the fastest interface the
+ *          loaded driver offers.
+ *
+ * The interfaces, fastest first, and what the library falls back to:
+ * - generation: the submission ring mapped from /dev/irqgen, else the
+ *   "line", "delay" and "amount" sysfs attributes;
+ * - stats: the "stats" page mapped read-only, else read() of the same
+ *   attribute, else the "total_handled" and "intr_handled" attributes;
+ * - samples of one line: the binary records of /dev/irqgen-line<N>, else
+ *   its CSV lines, else the CSV lines of /dev/irqgen filtered by line.
+ *
+ * The binary records are viewed where read() left them: the driver copies
+ * them once into the buffer of the stream, and a sample_ref only records
+ * where its record starts, reading a field when it is asked for. The CSV
+ * paths are parsed into the same kind of buffer, so that callers see one
+ * sample_range whatever the transport.
+ *
+ * /dev/irqgen can only be opened once: the device opens it on the first
+ * use of the ring or of the merged stream and shares it between them.
+ *
+ *   irqgen::task consume(irqgen::stream &s, irqgen::poller &loop)
+ *   {
+ *       for (;;)
+ *           for (irqgen::sample_ref r : co_await s.next(loop))
+ *               use(r.latency());
+ *   }
+ *
+ *   irqgen::device dev;
+ *   irqgen::poller loop;
+ *   irqgen::stream s = dev.channel(0);
+ *   irqgen::task t = consume(s, loop);
+ *   dev.enable(true);
+ *   dev.generate(0, 1000, 100);
+ *   loop.run();
+ *
+ * Coroutines get their arguments by reference: lambdas with captures would
+ * be destroyed before the coroutine is resumed.
+ */
+
+#ifndef __IRQGEN_HPP
+#define __IRQGEN_HPP
+
+#include <atomic>
+#include <charconv>
+#include <compare>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <iterator>
+#include <optional>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "irqgen_uapi.h"            // Binary interfaces of irqgen.ko
+
+namespace irqgen {
+
+inline constexpr const char *sysfs_dir = "/sys/kernel/irqgen";
+inline constexpr const char *dev_dir = "/dev";
+
+namespace detail {
+
+[[noreturn]] inline void fail(int err, const std::string &what)
+{
+    throw std::system_error(err, std::generic_category(), what);
+}
+
+// An owned file descriptor
+class fd {
+public:
+    fd() = default;
+    explicit fd(int v) : v_(v) {}
+    fd(fd &&o) noexcept : v_(std::exchange(o.v_, -1)) {}
+    fd &operator=(fd &&o) noexcept
+    {
+        if (this != &o) {
+            reset();
+            v_ = std::exchange(o.v_, -1);
+        }
+        return *this;
+    }
+    ~fd() { reset(); }
+
+    int get() const { return v_; }
+    explicit operator bool() const { return v_ >= 0; }
+    void reset()
+    {
+        if (v_ >= 0)
+            ::close(v_);
+        v_ = -1;
+    }
+
+private:
+    int v_ = -1;
+};
+
+// An owned shared mapping
+class mapping {
+public:
+    mapping() = default;
+    mapping(void *p, std::size_t len) : p_(p), len_(len) {}
+    mapping(mapping &&o) noexcept : p_(std::exchange(o.p_, nullptr)), len_(o.len_) {}
+    mapping &operator=(mapping &&o) noexcept
+    {
+        if (this != &o) {
+            reset();
+            p_ = std::exchange(o.p_, nullptr);
+            len_ = o.len_;
+        }
+        return *this;
+    }
+    ~mapping() { reset(); }
+
+    template <typename T> T *as() const { return static_cast<T *>(p_); }
+    explicit operator bool() const { return p_ != nullptr; }
+    void reset()
+    {
+        if (p_)
+            ::munmap(p_, len_);
+        p_ = nullptr;
+    }
+
+private:
+    void *p_ = nullptr;
+    std::size_t len_ = 0;
+};
+
+// Returns -errno instead of throwing, for the probes of the fallbacks
+inline int open_fd(const std::string &path, int flags, fd &out)
+{
+    int v = ::open(path.c_str(), flags | O_CLOEXEC);
+    if (v < 0)
+        return -errno;
+    out = fd(v);
+    return 0;
+}
+
+inline void *map(int f, std::size_t len, int prot)
+{
+    void *p = ::mmap(nullptr, len, prot, MAP_SHARED, f, 0);
+    return p == MAP_FAILED ? nullptr : p;
+}
+
+template <typename T> inline T load(const void *p)
+{
+    T v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline std::uint32_t load_acquire(const std::uint32_t &v)
+{
+    return std::atomic_ref<std::uint32_t>(const_cast<std::uint32_t &>(v))
+        .load(std::memory_order_acquire);
+}
+
+// Parse the unsigned integers of a line separated by `sep`, returns how many
+template <std::size_t N>
+inline std::size_t parse_u64(std::string_view s, char sep, std::uint64_t (&out)[N])
+{
+    std::size_t n = 0;
+    const char *p = s.data(), *end = s.data() + s.size();
+
+    while (n < N && p < end) {
+        auto [next, ec] = std::from_chars(p, end, out[n]);
+        if (ec != std::errc())
+            break;
+        ++n;
+        p = next;
+        while (p < end && (*p == sep || *p == ' ' || *p == '\n'))
+            ++p;
+    }
+    return n;
+}
+
+} // namespace detail
+
+/*-
+ * Layout of the records of a stream, from the header of a binary channel or
+ * synthesized for the CSV paths
+ */
+class schema {
+public:
+    schema() = default;
+    explicit schema(const struct irqgen_schema &h) : h_(h) {}
+
+    /*
+     * The layout of struct irqgen_sample, in which the CSV lines are parsed,
+     * with the fields of lines of `columns` values: 3 from older drivers
+     * (line, latency, timestamp), 5 with the batch and idx, 7 with the cpu
+     * and flags
+     */
+    static schema csv(std::size_t columns)
+    {
+        struct irqgen_schema h {};
+        auto set = [&h](int f, std::size_t off, std::size_t size) {
+            h.fields |= 1U << f;
+            h.layout[f].offset = static_cast<__u8>(off);
+            h.layout[f].size = static_cast<__u8>(size);
+        };
+
+        h.magic = IRQGEN_SCHEMA_MAGIC;
+        h.version = IRQGEN_SCHEMA_VERSION;
+        h.stride = sizeof(struct irqgen_sample);
+        set(IRQGEN_FIELD_TIMESTAMP, offsetof(struct irqgen_sample, timestamp), 8);
+        set(IRQGEN_FIELD_LATENCY, offsetof(struct irqgen_sample, latency), 4);
+        set(IRQGEN_FIELD_LINE, offsetof(struct irqgen_sample, line), 1);
+        if (columns >= 5) {
+            set(IRQGEN_FIELD_BATCH, offsetof(struct irqgen_sample, batch), 4);
+            set(IRQGEN_FIELD_IDX, offsetof(struct irqgen_sample, idx), 4);
+        }
+        if (columns >= 7) {
+            set(IRQGEN_FIELD_CPU, offsetof(struct irqgen_sample, cpu), 1);
+            set(IRQGEN_FIELD_FLAGS, offsetof(struct irqgen_sample, flags), 1);
+        }
+        return schema(h);
+    }
+
+    std::size_t stride() const { return h_.stride; }
+    std::uint32_t fields() const { return h_.fields; }
+    bool has(int field) const
+    {
+        return field >= 0 && field < IRQGEN_FIELD_MAX && (h_.fields & (1U << field)) &&
+               h_.layout[field].size != 0;
+    }
+    const struct irqgen_schema_field &place(int field) const { return h_.layout[field]; }
+
+private:
+    struct irqgen_schema h_ {};
+};
+
+/*-
+ * An owned copy of a sample, for keeping it past the next read
+ *
+ * Fields missing from the schema of the stream are 0.
+ */
+struct sample {
+    std::uint64_t timestamp;
+    std::uint32_t latency;
+    std::uint32_t publish;
+    std::uint32_t batch;
+    std::uint32_t idx;
+    std::uint32_t seq;
+    std::uint8_t line;
+    std::uint8_t cpu;
+    std::uint8_t flags;
+};
+
+/*-
+ * A view of one record in the buffer of a stream, valid until its next read
+ */
+class sample_ref {
+public:
+    sample_ref() = default;
+    sample_ref(const std::byte *rec, const schema *s) : rec_(rec), s_(s) {}
+
+    bool has(int field) const { return s_->has(field); }
+
+    // Value of any field, 0 if it is not in the records
+    std::uint64_t get(int field) const
+    {
+        if (!has(field))
+            return 0;
+
+        const std::byte *p = rec_ + s_->place(field).offset;
+        switch (s_->place(field).size) {
+        case 1: return detail::load<std::uint8_t>(p);
+        case 2: return detail::load<std::uint16_t>(p);
+        case 4: return detail::load<std::uint32_t>(p);
+        case 8: return detail::load<std::uint64_t>(p);
+        default: return 0;
+        }
+    }
+
+    std::uint64_t timestamp() const { return get(IRQGEN_FIELD_TIMESTAMP); }
+    std::uint32_t latency() const { return static_cast<std::uint32_t>(get(IRQGEN_FIELD_LATENCY)); }
+    std::uint32_t publish() const { return static_cast<std::uint32_t>(get(IRQGEN_FIELD_PUBLISH)); }
+    std::uint32_t batch() const { return static_cast<std::uint32_t>(get(IRQGEN_FIELD_BATCH)); }
+    std::uint32_t idx() const { return static_cast<std::uint32_t>(get(IRQGEN_FIELD_IDX)); }
+    std::uint32_t seq() const { return static_cast<std::uint32_t>(get(IRQGEN_FIELD_SEQ)); }
+    std::uint8_t line() const { return static_cast<std::uint8_t>(get(IRQGEN_FIELD_LINE)); }
+    std::uint8_t cpu() const { return static_cast<std::uint8_t>(get(IRQGEN_FIELD_CPU)); }
+    std::uint8_t flags() const { return static_cast<std::uint8_t>(get(IRQGEN_FIELD_FLAGS)); }
+
+    sample copy() const
+    {
+        return { timestamp(), latency(), publish(), batch(), idx(), seq(), line(), cpu(), flags() };
+    }
+
+    // The raw record, schema().stride() bytes
+    const std::byte *data() const { return rec_; }
+
+private:
+    const std::byte *rec_ = nullptr;
+    const schema *s_ = nullptr;
+};
+
+/*-
+ * Random access iterator over the records of a buffer
+ *
+ * Dereferencing yields a sample_ref by value: the records have no C++ type,
+ * their layout is only known at runtime.
+ */
+class sample_iterator {
+public:
+    using iterator_concept = std::random_access_iterator_tag;
+    using iterator_category = std::input_iterator_tag;
+    using value_type = sample_ref;
+    using difference_type = std::ptrdiff_t;
+
+    sample_iterator() = default;
+    sample_iterator(const std::byte *rec, const schema *s) : rec_(rec), s_(s) {}
+
+    sample_ref operator*() const { return sample_ref(rec_, s_); }
+    sample_ref operator[](difference_type n) const { return *(*this + n); }
+
+    sample_iterator &operator+=(difference_type n)
+    {
+        rec_ += n * static_cast<difference_type>(s_->stride());
+        return *this;
+    }
+    sample_iterator &operator-=(difference_type n) { return *this += -n; }
+    sample_iterator &operator++() { return *this += 1; }
+    sample_iterator &operator--() { return *this -= 1; }
+    sample_iterator operator++(int) { auto t = *this; ++*this; return t; }
+    sample_iterator operator--(int) { auto t = *this; --*this; return t; }
+
+    friend sample_iterator operator+(sample_iterator it, difference_type n) { return it += n; }
+    friend sample_iterator operator+(difference_type n, sample_iterator it) { return it += n; }
+    friend sample_iterator operator-(sample_iterator it, difference_type n) { return it -= n; }
+    friend difference_type operator-(const sample_iterator &a, const sample_iterator &b)
+    {
+        return (a.rec_ - b.rec_) / static_cast<difference_type>(a.s_->stride());
+    }
+    friend bool operator==(const sample_iterator &a, const sample_iterator &b) { return a.rec_ == b.rec_; }
+    friend std::strong_ordering operator<=>(const sample_iterator &a, const sample_iterator &b)
+    {
+        return std::compare_three_way()(a.rec_, b.rec_);
+    }
+
+private:
+    const std::byte *rec_ = nullptr;
+    const schema *s_ = nullptr;
+};
+
+/*-
+ * The records returned by one read of a stream, valid until the next one
+ */
+class sample_range : public std::ranges::view_interface<sample_range> {
+public:
+    sample_range() = default;
+    sample_range(const std::byte *first, std::size_t count, const schema *s)
+        : first_(first), count_(count), s_(s) {}
+
+    sample_iterator begin() const { return sample_iterator(first_, s_); }
+    sample_iterator end() const { return begin() + static_cast<std::ptrdiff_t>(count_); }
+    std::size_t size() const { return count_; }
+
+private:
+    const std::byte *first_ = nullptr;
+    std::size_t count_ = 0;
+    const schema *s_ = nullptr;
+};
+
+static_assert(std::random_access_iterator<sample_iterator>);
+static_assert(std::ranges::random_access_range<sample_range>);
+static_assert(std::ranges::view<sample_range>);
+
+/*-
+ * Minimal coroutine of the async consumers: started on creation, it runs
+ * until its first co_await that cannot complete, then is resumed by the
+ * poller. The frame is destroyed with the task.
+ */
+class task {
+public:
+    struct promise_type {
+        std::exception_ptr error;
+
+        task get_return_object() { return task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { error = std::current_exception(); }
+    };
+
+    task(task &&o) noexcept : h_(std::exchange(o.h_, {})) {}
+    task &operator=(task &&o) noexcept
+    {
+        if (this != &o) {
+            if (h_)
+                h_.destroy();
+            h_ = std::exchange(o.h_, {});
+        }
+        return *this;
+    }
+    ~task()
+    {
+        if (h_)
+            h_.destroy();
+    }
+
+    bool done() const { return !h_ || h_.done(); }
+    // Rethrows the exception that ended the coroutine, if any
+    void get() const
+    {
+        if (h_ && h_.promise().error)
+            std::rethrow_exception(h_.promise().error);
+    }
+
+private:
+    explicit task(std::coroutine_handle<promise_type> h) : h_(h) {}
+    std::coroutine_handle<promise_type> h_;
+};
+
+/*-
+ * Resumes the coroutines waiting for their file descriptors, with poll()
+ *
+ * The consumers wait on a handful of descriptors, so a single poll() per
+ * round costs no more than an io_uring poll submission would.
+ */
+class poller {
+public:
+    struct awaiter {
+        poller &loop;
+        int fd;
+        short events;
+        short revents = 0;
+
+        bool await_ready() const { return false; }
+        void await_suspend(std::coroutine_handle<> h) { loop.waiters_.push_back({ fd, events, &revents, h }); }
+        short await_resume() const { return revents; }
+    };
+
+    // co_await loop.wait(fd, POLLIN) returns the revents of fd
+    awaiter wait(int fd, short events) { return awaiter{ *this, fd, events }; }
+
+    bool idle() const { return waiters_.empty(); }
+
+    /*
+     * Wait up to timeout_ms (-1: forever) for the descriptors and resume
+     * the coroutines of those ready. Returns how many were resumed.
+     */
+    std::size_t run_once(int timeout_ms = -1)
+    {
+        if (waiters_.empty())
+            return 0;
+
+        pfds_.resize(waiters_.size());
+        for (std::size_t i = 0; i < waiters_.size(); ++i)
+            pfds_[i] = { waiters_[i].fd, waiters_[i].events, 0 };
+
+        int n = ::poll(pfds_.data(), pfds_.size(), timeout_ms);
+        if (n < 0) {
+            if (errno == EINTR)
+                return 0;
+            detail::fail(errno, "poll");
+        }
+
+        // Resumed coroutines may wait again: take the ready ones out first
+        std::vector<waiter> ready;
+        std::size_t kept = 0;
+        for (std::size_t i = 0; i < waiters_.size(); ++i) {
+            if (pfds_[i].revents) {
+                *waiters_[i].revents = pfds_[i].revents;
+                ready.push_back(waiters_[i]);
+            } else {
+                waiters_[kept++] = waiters_[i];
+            }
+        }
+        waiters_.resize(kept);
+
+        for (auto &w : ready)
+            w.h.resume();
+        return ready.size();
+    }
+
+    // Run until no coroutine waits any more
+    void run()
+    {
+        while (!waiters_.empty())
+            run_once(-1);
+    }
+
+private:
+    struct waiter {
+        int fd;
+        short events;
+        short *revents;
+        std::coroutine_handle<> h;
+    };
+
+    std::vector<waiter> waiters_;
+    std::vector<struct pollfd> pfds_;
+};
+
+/*-
+ * A stream of samples: one line from its channel node or from /dev/irqgen,
+ * or all the lines from /dev/irqgen
+ */
+class stream {
+public:
+    enum class transport {
+        binary,         // records of /dev/irqgen-line<N>
+        channel_csv,    // CSV lines of /dev/irqgen-line<N>
+        merged_csv,     // CSV lines of /dev/irqgen
+    };
+
+    stream(stream &&) = default;
+    stream &operator=(stream &&) = default;
+
+    transport kind() const { return kind_; }
+    const class schema &schema() const { return schema_; }
+    int fd() const { return fd_; }
+
+    /*
+     * Read the samples available now, without blocking. The range is empty
+     * if there are none; it is valid until the next read.
+     */
+    sample_range read()
+    {
+        return kind_ == transport::binary ? read_binary() : read_csv();
+    }
+
+    struct next_awaiter {
+        stream &s;
+        poller &loop;
+        sample_range r {};
+
+        bool await_ready()
+        {
+            r = s.read();
+            return !r.empty();
+        }
+        void await_suspend(std::coroutine_handle<> h)
+        {
+            inner_.emplace(loop.wait(s.fd(), POLLIN));
+            inner_->await_suspend(h);
+        }
+        sample_range await_resume()
+        {
+            if (r.empty())
+                r = s.read();
+            return r;
+        }
+
+        std::optional<poller::awaiter> inner_ {};
+    };
+
+    /*
+     * co_await s.next(loop): the next non-empty read, waiting in `loop` when
+     * there is nothing to read. The range may still be empty if a filtered
+     * merged stream only found samples of other lines.
+     */
+    next_awaiter next(poller &loop) { return next_awaiter{ *this, loop }; }
+
+private:
+    friend class device;
+
+    static constexpr std::size_t csv_max = 128;    // >= 60 bytes needed by the driver
+
+    stream(detail::fd owned, int f, transport kind, int line, std::size_t capacity)
+        : owned_(std::move(owned)), fd_(f), kind_(kind), line_(line)
+    {
+        if (kind_ == transport::binary) {
+            struct irqgen_schema h;
+            ssize_t n = ::read(fd_, &h, sizeof(h));
+            if (n < 0)
+                detail::fail(errno, "read of the channel schema");
+            if (n != sizeof(h) || h.magic != IRQGEN_SCHEMA_MAGIC || h.version != IRQGEN_SCHEMA_VERSION ||
+                h.stride == 0)
+                detail::fail(EPROTO, "channel schema");
+            schema_ = irqgen::schema(h);
+        } else {
+            // Only the columns every driver prints, until the first line
+            schema_ = irqgen::schema::csv(csv_columns_);
+        }
+        buf_.resize(capacity / schema_.stride() * schema_.stride());
+        if (buf_.empty())
+            detail::fail(EINVAL, "stream capacity");
+    }
+
+    // The driver copies whole records, up to a page per read()
+    sample_range read_binary()
+    {
+        std::size_t stride = schema_.stride(), used = 0;
+
+        while (buf_.size() - used >= stride) {
+            ssize_t n = ::read(fd_, buf_.data() + used, buf_.size() - used);
+            if (n < 0) {
+                if (errno == EINTR)
+                    continue;
+                if (errno == EAGAIN)
+                    break;
+                detail::fail(errno, "read of the channel");
+            }
+            if (n == 0)
+                break;
+            used += static_cast<std::size_t>(n);
+        }
+        return sample_range(buf_.data(), used / stride, &schema_);
+    }
+
+    /*
+     * One CSV line per read(): "line,latency,timestamp,batch,idx,cpu,flags".
+     * Older drivers print only the first 3 or 5 values: the missing fields
+     * are 0 and left out of the schema.
+     */
+    sample_range read_csv()
+    {
+        char text[csv_max];
+        std::size_t count = 0, max = buf_.size() / sizeof(struct irqgen_sample);
+
+        while (count < max) {
+            ssize_t n = ::read(fd_, text, sizeof(text));
+            if (n < 0) {
+                if (errno == EINTR)
+                    continue;
+                if (errno == EAGAIN)
+                    break;
+                detail::fail(errno, "read of the samples");
+            }
+            if (n == 0)
+                break;
+
+            std::uint64_t v[7] {};
+            std::size_t columns = detail::parse_u64(std::string_view(text, static_cast<std::size_t>(n)), ',', v);
+            if (columns < 3)
+                detail::fail(EPROTO, "sample line");
+            if (columns != csv_columns_) {
+                csv_columns_ = columns;
+                schema_ = irqgen::schema::csv(columns);
+            }
+            if (line_ >= 0 && v[0] != static_cast<std::uint64_t>(line_))
+                continue;
+
+            struct irqgen_sample s {};
+            s.line = static_cast<__u8>(v[0]);
+            s.latency = static_cast<__u32>(v[1]);
+            s.timestamp = v[2];
+            s.batch = static_cast<__u32>(v[3]);
+            s.idx = static_cast<__u32>(v[4]);
+            s.cpu = static_cast<__u8>(v[5]);
+            s.flags = static_cast<__u8>(v[6]);
+            std::memcpy(buf_.data() + count * sizeof(s), &s, sizeof(s));
+            ++count;
+        }
+        return sample_range(buf_.data(), count, &schema_);
+    }
+
+    detail::fd owned_;          // empty when sharing /dev/irqgen with the device
+    int fd_;
+    transport kind_;
+    int line_;                  // filter of the merged stream, -1 for all
+    class schema schema_;
+    std::size_t csv_columns_ = 3;   // values in the last CSV line parsed
+    std::vector<std::byte> buf_;
+};
+
+/*-
+ * Counters of one line, from the stats page
+ */
+struct line_stats {
+    std::uint32_t handled;
+    std::uint32_t dropped;
+    std::uint32_t last_latency;
+    std::uint64_t last_ns;
+};
+
+/*-
+ * A consistent snapshot of the counters of the driver
+ *
+ * @from_page: false on drivers without the stats page, where only the
+ *             handled counters are known
+ */
+struct stats {
+    std::uint32_t total_handled = 0;
+    std::uint32_t dropped = 0;
+    std::vector<line_stats> lines;
+    bool from_page = true;
+};
+
+/*-
+ * A completion of the submission ring, see struct irqgen_cqe
+ */
+using completion = struct irqgen_cqe;
+
+/*-
+ * The IRQ Generator: its sysfs commands, the submission ring and stats page
+ * it maps, and the sample streams it opens
+ */
+class device {
+public:
+    explicit device(std::string sysfs = sysfs_dir, std::string dev = dev_dir)
+        : sysfs_(std::move(sysfs)), dev_(std::move(dev)) {}
+
+    device(const device &) = delete;
+    device &operator=(const device &) = delete;
+
+    /* --- sysfs attributes --- */
+    std::string read_attr(const std::string &name) const
+    {
+        detail::fd f;
+        std::string out(4096, '\0');
+
+        if (int err = detail::open_fd(sysfs_ + "/" + name, O_RDONLY, f))
+            detail::fail(-err, name);
+        ssize_t n = ::read(f.get(), out.data(), out.size());
+        if (n < 0)
+            detail::fail(errno, name);
+        out.resize(static_cast<std::size_t>(n));
+        return out;
+    }
+
+    void write_attr(const std::string &name, std::string_view value) const
+    {
+        detail::fd f;
+
+        if (int err = detail::open_fd(sysfs_ + "/" + name, O_WRONLY, f))
+            detail::fail(-err, name);
+        if (::write(f.get(), value.data(), value.size()) < 0)
+            detail::fail(errno, name);
+    }
+
+    unsigned line_count() const
+    {
+        std::uint64_t v[1];
+        if (detail::parse_u64(read_attr("line_count"), ' ', v) != 1)
+            detail::fail(EPROTO, "line_count");
+        return static_cast<unsigned>(v[0]);
+    }
+
+    bool enabled() const { return read_attr("enabled").starts_with("1"); }
+    void enable(bool on) const { write_attr("enabled", on ? "1" : "0"); }
+
+    void pingpong(unsigned line, unsigned delay, unsigned iterations) const
+    {
+        write_attr("pingpong", std::to_string(line) + " " + std::to_string(delay) + " " +
+                                   std::to_string(iterations));
+    }
+    void pingpong_stop() const { write_attr("pingpong", "stop"); }
+
+    // Size and fields (0: keep the current ones) of the channel of a line
+    void set_channel(unsigned line, std::uint32_t size, std::uint32_t fields = 0) const
+    {
+        write_attr("channels", std::to_string(line) + " " + std::to_string(size) + " " +
+                                   std::to_string(fields));
+    }
+    void set_merged(bool on) const { write_attr("merged", on ? "1" : "0"); }
+
+    /* --- generation --- */
+
+    // Whether generate() goes through the submission ring
+    bool has_ring() { return map_ring(); }
+
+    /*
+     * Generate `amount` IRQs on `line`. Through the ring the command is
+     * queued behind the previous ones and its completion can be reaped with
+     * `user_data`; returns false if the submission queue is full. Through
+     * sysfs the command replaces the one running on the line.
+     */
+    bool generate(unsigned line, unsigned amount, unsigned delay, std::uint64_t user_data = 0,
+                  std::uint8_t sqe_flags = 0)
+    {
+        if (!map_ring()) {
+            write_attr("line", std::to_string(line));
+            write_attr("delay", std::to_string(delay));
+            write_attr("amount", std::to_string(amount));
+            return true;
+        }
+
+        auto *hdr = ring_.as<struct irqgen_ring_hdr>();
+        auto *sqes = reinterpret_cast<struct irqgen_sqe *>(ring_.as<std::byte>() + hdr->sq_off);
+        std::atomic_ref<std::uint32_t> tail(hdr->sq_tail), flags(hdr->flags);
+        std::uint32_t t = tail.load(std::memory_order_relaxed);
+
+        if (t - detail::load_acquire(hdr->sq_head) >= hdr->sq_entries)
+            return false;
+
+        struct irqgen_sqe &sqe = sqes[t & (hdr->sq_entries - 1)];
+        sqe = {};
+        sqe.user_data = user_data;
+        sqe.amount = static_cast<__u16>(amount);
+        sqe.delay = static_cast<__u16>(delay);
+        sqe.line = static_cast<__u8>(line);
+        sqe.flags = sqe_flags;
+        tail.store(t + 1, std::memory_order_release);
+
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if ((flags.load(std::memory_order_relaxed) & IRQGEN_RING_NEED_WAKEUP) &&
+            ::ioctl(chardev(), IRQGEN_IOC_RING_ENTER) < 0)
+            detail::fail(errno, "IRQGEN_IOC_RING_ENTER");
+        return true;
+    }
+
+    // The next completion of the ring, if any (never with the sysfs path)
+    std::optional<completion> reap()
+    {
+        if (!map_ring())
+            return std::nullopt;
+
+        auto *hdr = ring_.as<struct irqgen_ring_hdr>();
+        auto *cqes = reinterpret_cast<const struct irqgen_cqe *>(ring_.as<std::byte>() + hdr->cq_off);
+        std::atomic_ref<std::uint32_t> head(hdr->cq_head);
+        std::uint32_t h = head.load(std::memory_order_relaxed);
+
+        if (h == detail::load_acquire(hdr->cq_tail))
+            return std::nullopt;
+        completion c = cqes[h & (hdr->cq_entries - 1)];
+        head.store(h + 1, std::memory_order_release);
+        return c;
+    }
+
+    /* --- stats --- */
+    struct stats stats()
+    {
+        struct irqgen_stats_page p;
+
+        if (!stats_probed_) {
+            stats_probed_ = true;
+            if (detail::open_fd(sysfs_ + "/stats", O_RDONLY, stats_fd_) == 0) {
+                void *m = detail::map(stats_fd_.get(), sizeof(p), PROT_READ);
+                if (m)
+                    stats_page_ = detail::mapping(m, sizeof(p));
+            }
+        }
+
+        if (stats_page_)
+            snapshot_page(*stats_page_.as<const struct irqgen_stats_page>(), p);
+        else if (stats_fd_)
+            snapshot_read(p);
+        else
+            return stats_text();
+
+        struct stats s;
+        s.total_handled = p.total_handled;
+        s.dropped = p.dropped;
+        for (unsigned i = 0; i < p.line_count && i < IRQGEN_STATS_MAX_LINES; ++i)
+            s.lines.push_back({ p.lines[i].handled, p.lines[i].dropped, p.lines[i].last_latency,
+                                p.lines[i].last_ns });
+        return s;
+    }
+
+    /* --- samples --- */
+
+    // All the lines, as CSV lines of /dev/irqgen; shares its descriptor
+    stream merged(std::size_t capacity = 64 * 1024)
+    {
+        return stream({}, chardev(), stream::transport::merged_csv, -1, capacity);
+    }
+
+    /*
+     * The samples of one line, on the fastest interface available: binary
+     * records of its channel, else its CSV lines, else /dev/irqgen filtered
+     * (which also needs "merged" on in the driver).
+     */
+    stream channel(unsigned line, std::size_t capacity = 64 * 1024)
+    {
+        detail::fd f;
+        int err = detail::open_fd(dev_ + "/irqgen-line" + std::to_string(line), O_RDONLY, f);
+
+        if (err == 0) {
+            int v = f.get();
+            if (::ioctl(v, IRQGEN_IOC_CHAN_BINARY) == 0)
+                return stream(std::move(f), v, stream::transport::binary, static_cast<int>(line), capacity);
+            if (errno != ENOTTY)
+                detail::fail(errno, "IRQGEN_IOC_CHAN_BINARY");
+            return stream(std::move(f), v, stream::transport::channel_csv, static_cast<int>(line), capacity);
+        }
+        // Drivers without channels, or with this one disabled
+        if (err != -ENOENT && err != -ENODEV)
+            detail::fail(-err, "irqgen-line" + std::to_string(line));
+
+        return stream({}, chardev(), stream::transport::merged_csv, static_cast<int>(line), capacity);
+    }
+
+private:
+    int chardev()
+    {
+        if (!chardev_) {
+            if (int err = detail::open_fd(dev_ + "/irqgen", O_RDWR, chardev_))
+                detail::fail(-err, dev_ + "/irqgen");
+        }
+        return chardev_.get();
+    }
+
+    // Map the rings once; false if the driver has none or /dev/irqgen is busy
+    bool map_ring()
+    {
+        if (ring_probed_)
+            return static_cast<bool>(ring_);
+        ring_probed_ = true;
+
+        if (!chardev_ && detail::open_fd(dev_ + "/irqgen", O_RDWR, chardev_) != 0)
+            return false;
+
+        // The header tells the size of the whole mapping
+        long page = ::sysconf(_SC_PAGESIZE);
+        void *m = detail::map(chardev_.get(), static_cast<std::size_t>(page), PROT_READ);
+        if (!m)
+            return false;
+        auto *hdr = static_cast<const struct irqgen_ring_hdr *>(m);
+        std::size_t len = hdr->cq_off + hdr->cq_entries * sizeof(struct irqgen_cqe);
+        ::munmap(m, static_cast<std::size_t>(page));
+
+        m = detail::map(chardev_.get(), len, PROT_READ | PROT_WRITE);
+        if (!m)
+            return false;
+        ring_ = detail::mapping(m, len);
+        return true;
+    }
+
+    // Seqlock read of the page, see struct irqgen_stats_page
+    static void snapshot_page(const struct irqgen_stats_page &src, struct irqgen_stats_page &dst)
+    {
+        for (;;) {
+            std::uint32_t seq = detail::load_acquire(src.seq);
+            if (seq & 1)
+                continue;
+            std::memcpy(&dst, &src, sizeof(dst));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (detail::load_acquire(src.seq) == seq)
+                return;
+        }
+    }
+
+    // Without mmap: two reads with the same even sequence are consistent
+    void snapshot_read(struct irqgen_stats_page &dst) const
+    {
+        struct irqgen_stats_page prev;
+
+        if (::pread(stats_fd_.get(), &prev, sizeof(prev), 0) != sizeof(prev))
+            detail::fail(errno ? errno : EPROTO, "stats");
+        for (;;) {
+            if (::pread(stats_fd_.get(), &dst, sizeof(dst), 0) != sizeof(dst))
+                detail::fail(errno ? errno : EPROTO, "stats");
+            if (!(dst.seq & 1) && dst.seq == prev.seq)
+                return;
+            prev = dst;
+        }
+    }
+
+    struct stats stats_text() const
+    {
+        struct stats s;
+        std::uint64_t total[1], handled[IRQGEN_STATS_MAX_LINES];
+
+        s.from_page = false;
+        if (detail::parse_u64(read_attr("total_handled"), ' ', total) == 1)
+            s.total_handled = static_cast<std::uint32_t>(total[0]);
+        std::size_t n = detail::parse_u64(read_attr("intr_handled"), ' ', handled);
+        for (std::size_t i = 0; i < n; ++i)
+            s.lines.push_back({ static_cast<std::uint32_t>(handled[i]), 0, 0, 0 });
+        return s;
+    }
+
+    std::string sysfs_;
+    std::string dev_;
+    detail::fd chardev_;
+    detail::mapping ring_;
+    bool ring_probed_ = false;
+    detail::fd stats_fd_;
+    detail::mapping stats_page_;
+    bool stats_probed_ = false;
+};
+
+} // namespace irqgen
+
+#endif /* !defined(__IRQGEN_HPP) */
@@ -0,0 +1,100 @@
+/**
+ * @file   irqgen_tail.cpp
+ * @date   17 October 2026
+ * @target_device Xilinx PYNQ-Z1, or any Linux machine with irqgen_emul.ko
+ * @brief   Print the samples of irqgen.ko as CSV lines, consumed
+ *          asynchronously through irqgen.hpp.
+ *
+ * usage: irqgen-tail [-l line] [-n count] [-g amount:delay]
+ *
+ *   -l  only the samples of this line, from its channel (all the lines)
+ *   -n  exit after this many samples (never)
+ *   -g  enable the generator and generate on the line (0 without -l)
+ *
+ * The transport picked for the samples and the generation is reported on
+ * stderr, and a stats snapshot when exiting.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+
+#include <unistd.h>
+
+#include "irqgen.hpp"
+
+static const char *transport_name(irqgen::stream::transport t)
+{
+    switch (t) {
+    case irqgen::stream::transport::binary:      return "binary channel";
+    case irqgen::stream::transport::channel_csv: return "CSV channel";
+    case irqgen::stream::transport::merged_csv:  return "CSV /dev/irqgen";
+    }
+    return "?";
+}
+
+static irqgen::task tail(irqgen::stream &s, irqgen::poller &loop, long count)
+{
+    long seen = 0;
+
+    while (count < 0 || seen < count) {
+        for (irqgen::sample_ref r : co_await s.next(loop)) {
+            std::printf("%u,%u,%llu,%u,%u,%u,%u\n", r.line(), r.latency(),
+                        (unsigned long long)r.timestamp(), r.batch(), r.idx(), r.cpu(), r.flags());
+            if (++seen == count)
+                break;
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int opt, line = -1;
+    long count = -1;
+    unsigned amount = 0, delay = 0;
+
+    while ((opt = getopt(argc, argv, "l:n:g:")) != -1) {
+        switch (opt) {
+        case 'l': line = std::atoi(optarg); break;
+        case 'n': count = std::atol(optarg); break;
+        case 'g':
+            if (std::sscanf(optarg, "%u:%u", &amount, &delay) != 2) {
+                std::fprintf(stderr, "bad generation: %s\n", optarg);
+                return 2;
+            }
+            break;
+        default:
+            std::fprintf(stderr, "usage: %s [-l line] [-n count] [-g amount:delay]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    try {
+        irqgen::device dev;
+        irqgen::poller loop;
+        irqgen::stream s = line >= 0 ? dev.channel(line) : dev.merged();
+
+        std::fprintf(stderr, "samples: %s\n", transport_name(s.kind()));
+        irqgen::task t = tail(s, loop, count);
+
+        if (amount) {
+            std::fprintf(stderr, "generation: %s\n", dev.has_ring() ? "submission ring" : "sysfs");
+            dev.enable(true);
+            if (!dev.generate(line >= 0 ? line : 0, amount, delay))
+                std::fprintf(stderr, "submission queue full\n");
+        }
+
+        while (!t.done())
+            loop.run_once();
+        t.get();
+
+        irqgen::stats st = dev.stats();
+        std::fprintf(stderr, "handled %u, dropped %u%s\n", st.total_handled, st.dropped,
+                     st.from_page ? "" : " (no stats page)");
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "irqgen-tail: %s\n", e.what());
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1 @@
+../../../recipes-kernel/irqgen-mod/files/irqgen_uapi.h
\ No newline at end of file
@@ -0,0 +1,217 @@
+/**
+ * @file   irqgen_uio.c
+ * @date   17 October 2026
+ * @target_device Xilinx PYNQ-Z1
+ * @brief   Userspace driver for the IRQ Generator IP block, on top of the
+ *          UIO binding of irqgen_uio.ko.
+ */
+
+#define _GNU_SOURCE
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>                  // sched_getcpu
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>              // ntohl
+#include <sys/mman.h>
+
+#include "irqgen_uio.h"
+
+/* Register map, as in irqgen_addresses.h */
+#define IRQGEN_CTRL_REG_OFFSET    0x0000
+#define IRQGEN_GENIRQ_REG_OFFSET  0x0004
+#define IRQGEN_LATENCY_REG_OFFSET 0x000C
+
+#define IRQGEN_CTRL_REG_F_ENABLE  (1U << 0)
+#define IRQGEN_CTRL_REG_F_HANDLED (1U << 1)
+#define IRQGEN_CTRL_REG_F_ACK     (0xFU << 2)
+#define IRQGEN_CTRL_ACK_SHIFT     2
+
+#define IRQGEN_GENIRQ_LINE_SHIFT   0
+#define IRQGEN_GENIRQ_DELAY_SHIFT  6
+#define IRQGEN_GENIRQ_AMOUNT_SHIFT 20
+
+#define UIO_CLASS "/sys/class/uio"
+
+#define REG(u, off) ((u)->regs[(off) / sizeof(uint32_t)])
+
+// Find the uioN named "irqgen-line<line>": stores N. Returns 0 or -errno.
+static int irqgen_uio_find(int line, int *uio)
+{
+    char path[300], name[32], want[32];
+    struct dirent *e;
+    DIR *d;
+    int ret = -ENODEV;
+
+    snprintf(want, sizeof(want), "irqgen-line%d\n", line);
+
+    d = opendir(UIO_CLASS);
+    if (NULL == d)
+        return -errno;
+    while (NULL != (e = readdir(d))) {
+        FILE *f;
+
+        if (1 != sscanf(e->d_name, "uio%d", uio))
+            continue;
+        snprintf(path, sizeof(path), UIO_CLASS "/%s/name", e->d_name);
+        f = fopen(path, "r");
+        if (NULL == f)
+            continue;
+        if (NULL != fgets(name, sizeof(name), f) && 0 == strcmp(name, want))
+            ret = 0;
+        fclose(f);
+        if (0 == ret)
+            break;
+    }
+    closedir(d);
+
+    return ret;
+}
+
+// Read the ack value of `line` from the device tree node of the device
+static int irqgen_uio_read_ack(int uio, int line, uint32_t *ack)
+{
+    char path[128];
+    uint32_t be;
+    int fd, ret = 0;
+
+    snprintf(path, sizeof(path), UIO_CLASS "/uio%d/device/of_node/wapice,intrack", uio);
+    fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return -errno;
+    if (pread(fd, &be, sizeof(be), line * sizeof(be)) != sizeof(be))
+        ret = -EINVAL;
+    else
+        *ack = ntohl(be);
+    close(fd);
+
+    return ret;
+}
+
+static int irqgen_uio_read_size(int uio, size_t *size)
+{
+    char path[128];
+    unsigned long v;
+    FILE *f;
+    int ret = 0;
+
+    snprintf(path, sizeof(path), UIO_CLASS "/uio%d/maps/map0/size", uio);
+    f = fopen(path, "r");
+    if (NULL == f)
+        return -errno;
+    if (1 != fscanf(f, "%lx", &v))
+        ret = -EINVAL;
+    else
+        *size = v;
+    fclose(f);
+
+    return ret;
+}
+
+int irqgen_uio_open(struct irqgen_uio *u, int line, int busy_poll)
+{
+    char path[32];
+    void *map;
+    int uio, ret;
+    int32_t on = 1;
+
+    memset(u, 0, sizeof(*u));
+    u->fd = -1;
+    u->line = line;
+    u->busy_poll = busy_poll;
+
+    if ((ret = irqgen_uio_find(line, &uio)) != 0 ||
+        (ret = irqgen_uio_read_ack(uio, line, &u->ack)) != 0 ||
+        (ret = irqgen_uio_read_size(uio, &u->map_size)) != 0)
+        return ret;
+
+    snprintf(path, sizeof(path), "/dev/uio%d", uio);
+    u->fd = open(path, O_RDWR | (busy_poll ? O_NONBLOCK : 0));
+    if (u->fd < 0)
+        return -errno;
+
+    // Map 0 is at offset 0
+    map = mmap(NULL, u->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, u->fd, 0);
+    if (MAP_FAILED == map) {
+        ret = -errno;
+        irqgen_uio_close(u);
+        return ret;
+    }
+    u->regs = map;
+
+    // The IRQ starts unmasked, this only drops a stale mask
+    if (write(u->fd, &on, sizeof(on)) != sizeof(on)) {
+        ret = -errno;
+        irqgen_uio_close(u);
+        return ret;
+    }
+
+    return 0;
+}
+
+void irqgen_uio_close(struct irqgen_uio *u)
+{
+    if (NULL != u->regs && u->enabled)
+        irqgen_uio_enable(u, 0);
+    if (NULL != u->regs)
+        munmap((void *)u->regs, u->map_size);
+    if (u->fd >= 0)
+        close(u->fd);
+    u->regs = NULL;
+    u->fd = -1;
+}
+
+void irqgen_uio_enable(struct irqgen_uio *u, int on)
+{
+    REG(u, IRQGEN_CTRL_REG_OFFSET) = on ? IRQGEN_CTRL_REG_F_ENABLE : 0;
+    u->enabled = on;
+}
+
+void irqgen_uio_generate(struct irqgen_uio *u, uint16_t amount, uint16_t delay)
+{
+    if (!u->enabled)
+        irqgen_uio_enable(u, 1);
+    REG(u, IRQGEN_GENIRQ_REG_OFFSET) = 0
+        | ((uint32_t)amount << IRQGEN_GENIRQ_AMOUNT_SHIFT)
+        | ((uint32_t)delay << IRQGEN_GENIRQ_DELAY_SHIFT)
+        | ((uint32_t)u->line << IRQGEN_GENIRQ_LINE_SHIFT);
+}
+
+int irqgen_uio_wait(struct irqgen_uio *u, struct irqgen_sample *s)
+{
+    struct timespec ts;
+    uint32_t count, regvalue;
+    int32_t on = 1;
+    ssize_t n;
+
+    // Busy polling spins on the non-blocking read
+    do {
+        n = read(u->fd, &count, sizeof(count));
+    } while (n < 0 && (EINTR == errno || (u->busy_poll && EAGAIN == errno)));
+    if (n != sizeof(count))
+        return n < 0 ? -errno : -EIO;
+
+    // Same clock as ktime_get_ns() at the start of irqgen_irqhandler()
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    regvalue = REG(u, IRQGEN_CTRL_REG_OFFSET);
+    regvalue &= ~(IRQGEN_CTRL_REG_F_HANDLED | IRQGEN_CTRL_REG_F_ACK);
+    regvalue |= IRQGEN_CTRL_REG_F_HANDLED
+                | ((u->ack << IRQGEN_CTRL_ACK_SHIFT) & IRQGEN_CTRL_REG_F_ACK);
+    REG(u, IRQGEN_CTRL_REG_OFFSET) = regvalue;
+
+    memset(s, 0, sizeof(*s));
+    s->timestamp = (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    s->latency = REG(u, IRQGEN_LATENCY_REG_OFFSET);
+    s->line = u->line;
+    s->cpu = sched_getcpu();
+
+    // Acknowledged: unmask the IRQ for the next one
+    if (write(u->fd, &on, sizeof(on)) != sizeof(on))
+        return -errno;
+
+    return 0;
+}
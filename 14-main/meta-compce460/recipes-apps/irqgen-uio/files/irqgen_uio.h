@@ -0,0 +1,61 @@
+/**
+ * @file   irqgen_uio.h
+ * @date   17 October 2026
+ * @target_device Xilinx PYNQ-Z1
+ * @brief   Userspace driver for the IRQ Generator IP block, on top of the
+ *          UIO binding of irqgen_uio.ko.
+ */
+
+#ifndef __IRQGEN_UIO_H
+#define __IRQGEN_UIO_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "irqgen_uapi.h"            // struct irqgen_sample
+
+/*-
+ * One IRQ line of the IRQ Generator, exported as /dev/uioN
+ *
+ * @line: index of the IRQ line
+ * @ack: ack value of the line, from the "wapice,intrack" property
+ * @fd: the opened /dev/uioN
+ * @busy_poll: whether irqgen_uio_wait() spins instead of sleeping
+ * @enabled: whether this handle enabled the IRQ Generator
+ * @regs: the mapped register space
+ * @map_size: size of the mapping in bytes
+ */
+struct irqgen_uio {
+    int line;
+    uint32_t ack;
+    int fd;
+    int busy_poll;
+    int enabled;
+    volatile uint32_t *regs;
+    size_t map_size;
+};
+
+// Open the UIO device of `line` and map its registers. Returns 0 or -errno.
+int irqgen_uio_open(struct irqgen_uio *u, int line, int busy_poll);
+// Also disables the IRQ Generator if this handle enabled it
+void irqgen_uio_close(struct irqgen_uio *u);
+
+/*
+ * Enable or disable the IRQ Generator, see enable_irq_generator(): nothing
+ * else does while irqgen_uio.ko is bound, and irqgen.ko leaves it disabled
+ * when it is removed.
+ */
+void irqgen_uio_enable(struct irqgen_uio *u, int on);
+
+// Generate `amount` IRQs on the line, see do_generate_irqs(). Enables the
+// IRQ Generator first if needed.
+void irqgen_uio_generate(struct irqgen_uio *u, uint16_t amount, uint16_t delay);
+
+/*
+ * Wait for the next IRQ of the line and handle it as irqgen_irqhandler()
+ * does, filling `s` in the format of the kernel driver: cpu is the CPU of
+ * the calling thread, batch, idx and flags are 0. Returns 0 or -errno.
+ */
+int irqgen_uio_wait(struct irqgen_uio *u, struct irqgen_sample *s);
+
+#endif /* !defined(__IRQGEN_UIO_H) */
@@ -0,0 +1,90 @@
+/**
+ * @file   irqgen_uio_dump.c
+ * @date   17 October 2026
+ * @target_device Xilinx PYNQ-Z1
+ * @brief   Handle the IRQs of one line of the IRQ Generator from userspace,
+ *          printing the samples as /dev/irqgen does.
+ *
+ * usage: irqgen-uio-dump [-l line] [-n count] [-d delay] [-g] [-b] [-c cpu]
+ *
+ *   -l  IRQ line to handle (0)
+ *   -n  IRQs to handle (1000)
+ *   -g  generate the IRQs, with the delay given by -d (0)
+ *   -b  busy poll instead of sleeping in read()
+ *   -c  CPU to run on, preferably an isolated one
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "irqgen_uio.h"
+
+#define IRQGEN_MAX_AMOUNT 0xFFF     // 12 bits of the GENIRQ register
+
+int main(int argc, char **argv)
+{
+    struct irqgen_uio u;
+    struct irqgen_sample s;
+    long line = 0, count = 1000, delay = 0, cpu = -1;
+    int busy_poll = 0, generate = 0;
+    long i, pending = 0;
+    int opt, ret;
+
+    while ((opt = getopt(argc, argv, "l:n:d:gbc:")) != -1) {
+        switch (opt) {
+        case 'l': line = strtol(optarg, NULL, 0); break;
+        case 'n': count = strtol(optarg, NULL, 0); break;
+        case 'd': delay = strtol(optarg, NULL, 0); break;
+        case 'g': generate = 1; break;
+        case 'b': busy_poll = 1; break;
+        case 'c': cpu = strtol(optarg, NULL, 0); break;
+        default:
+            fprintf(stderr, "usage: %s [-l line] [-n count] [-d delay] [-g] [-b] [-c cpu]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (cpu >= 0) {
+        cpu_set_t set;
+
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+            perror("sched_setaffinity");
+            return 1;
+        }
+    }
+
+    ret = irqgen_uio_open(&u, line, busy_poll);
+    if (0 != ret) {
+        fprintf(stderr, "irqgen_uio_open(%ld): %s\n", line, strerror(-ret));
+        return 1;
+    }
+
+    for (i = 0; i < count; ++i) {
+        if (generate && 0 == pending) {
+            pending = count - i < IRQGEN_MAX_AMOUNT ? count - i : IRQGEN_MAX_AMOUNT;
+            irqgen_uio_generate(&u, pending, delay);
+        }
+
+        ret = irqgen_uio_wait(&u, &s);
+        if (0 != ret) {
+            fprintf(stderr, "irqgen_uio_wait(): %s\n", strerror(-ret));
+            break;
+        }
+        if (pending > 0)
+            --pending;
+
+        // The CSV format of /dev/irqgen
+        printf("%u,%u,%llu,%u,%u,%u,%u\n", s.line, s.latency,
+               (unsigned long long)s.timestamp, s.batch, s.idx, s.cpu, s.flags);
+    }
+
+    irqgen_uio_close(&u);
+    return 0 == ret ? 0 : 1;
+}
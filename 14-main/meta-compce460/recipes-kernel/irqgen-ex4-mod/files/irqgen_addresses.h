@@ -1,35 +0,0 @@
-#ifndef __IRQGEN_ADDRESSES_H
-#define __IRQGEN_ADDRESSES_H
-
-/* IRQ Generator core register address space from devicetree.dts */
-# define IRQGEN_REG_PHYS_BASE 0x43c00000 //  find the right address for the register from the device tree
-# define IRQGEN_REG_PHYS_SIZE 0x10000 //  find the size of the register address space from the device tree
-
-/* IRQ Generator register address map from irq_generator_v1_1.pdf */
-# define IRQGEN_CTRL_REG_OFFSET 0x0000 //  check in the reference documentation
-# define IRQGEN_GENIRQ_REG_OFFSET 0x0004 //  check in the reference documentation
-# define IRQGEN_IRQ_COUNT_REG_OFFSET 0x0008 //  check in the reference documentation
-# define IRQGEN_LATENCY_REG_OFFSET 0x000C //  check in the reference documentation
-
-# define IRQGEN_CTRL_REG      (irqgen_reg_base + IRQGEN_CTRL_REG_OFFSET)
-# define IRQGEN_GENIRQ_REG    (irqgen_reg_base + IRQGEN_GENIRQ_REG_OFFSET)
-# define IRQGEN_IRQ_COUNT_REG (irqgen_reg_base + IRQGEN_IRQ_COUNT_REG_OFFSET)
-# define IRQGEN_LATENCY_REG   (irqgen_reg_base + IRQGEN_LATENCY_REG_OFFSET)
-
-/* --- bitfield defines for HW registers' fields --- */
-# include <linux/bitfield.h>         // bitfield macros for writing the HW registers
-
-# define IRQGEN_CTRL_REG_F_ENABLE             BIT(0) //  check in the reference documentation
-# define IRQGEN_CTRL_REG_F_HANDLED            BIT(1) //  check in the reference documentation
-# define IRQGEN_CTRL_REG_F_ACK        GENMASK( 5, 2) // check in the reference documentation
-
-# define IRQGEN_GENIRQ_REG_F_LINE     GENMASK( 3, 0) //  check in the reference documentation
-# define IRQGEN_GENIRQ_REG_F_DELAY    GENMASK( 19, 6) //  check in the reference documentation
-# define IRQGEN_GENIRQ_REG_F_AMOUNT   GENMASK( 31, 20) //  check in the reference documentation
-
-# define IRQGEN_MAX_LINE   (FIELD_GET(IRQGEN_GENIRQ_REG_F_LINE  , 0xFFFFFFFFL))
-# define IRQGEN_MAX_DELAY  (FIELD_GET(IRQGEN_GENIRQ_REG_F_DELAY , 0xFFFFFFFFL))
-# define IRQGEN_MAX_AMOUNT (FIELD_GET(IRQGEN_GENIRQ_REG_F_AMOUNT, 0xFFFFFFFFL))
-
-#endif /* !defined(__IRQGEN_ADDRESSES_H) */
-
@@ -1 +0,0 @@
-irqgen.c
\ No newline at end of file
@@ -3,15 +3,26 @@
 
 #include <linux/platform_device.h>  // Platform device related functions
 
-#ifdef DEBUG
-# define DRIVER_NAME "irqgen_dbg"
-# define DRIVER_LNAME "IRQ Generator module (DEBUG build)"
-# define KMSG_PFX "IRQGEN_DBG: "
-#else
-# define DRIVER_NAME "irqgen"
-# define DRIVER_LNAME "IRQ Generator module"
-# define KMSG_PFX "IRQGEN: "
-#endif
+#include <linux/jump_label.h>      // Static keys
+#include <linux/sched/clock.h>      // local_clock
+#include <linux/wait.h>             // Wait queues
+
+#include "irqgen_uapi.h"            // Binary interfaces shared with userspace
+
+#define DRIVER_NAME "irqgen"
+#define DRIVER_LNAME "IRQ Generator module"
+#define KMSG_PFX "IRQGEN: "
+
+/*
+ * Runtime switches for the optional code paths, toggled through sysfs.
+ * When a switch is off its code is skipped with no hot-path cost.
+ *
+ * @irqgen_debug_key: per-IRQ debug messages (off by default)
+ * @irqgen_instr_key: statistics kept by the handler, e.g. the rollups and
+ *                    the handler self-time profile (on by default)
+ */
+DECLARE_STATIC_KEY_FALSE(irqgen_debug_key);
+DECLARE_STATIC_KEY_TRUE(irqgen_instr_key);
 
 /*-
  * Structure for the latency buffer
@@ -19,13 +30,266 @@
  * @latency: number of clock cycles reported by the FPGA module between
  *           IRQ issue and acknowledgment
  * @line: which interrupt line generated the IRQ
+ * @cpu: the CPU which handled the IRQ
  * @timestamp: timestamp in ns when the handler was started for this IRQ
  *             request
+ * @flags: IRQGEN_SAMPLE_* flags
+ * @publish_ns: ns between @timestamp and the moment the sample became
+ *              visible to readers (0 if instrumentation is off)
+ * @batch: ID of the generation command which issued the IRQ (0 if unknown)
+ * @idx: index of the IRQ within its batch
+ *
+ * The optional fields are only there with the feature which fills them in,
+ * so that a build without it keeps the 16 bytes of the mandatory ones per
+ * sample in the merged ring.
  */
 struct latency_data {
+    u64 timestamp;
     u32 latency;
     u8  line;
+    u8  cpu;
+    u8  flags;
+#ifdef IRQGEN_CONFIG_STATS
+    u32 publish_ns;
+#endif
+#ifdef IRQGEN_CONFIG_BATCHES
+    u32 batch;
+    u32 idx;
+#endif
+};
+
+// The batch fields of a sample, 0 without IRQGEN_CONFIG_BATCHES
+static inline u32 latency_data_batch(const struct latency_data *v)
+{
+#ifdef IRQGEN_CONFIG_BATCHES
+    return v->batch;
+#else
+    return 0;
+#endif
+}
+
+static inline u32 latency_data_idx(const struct latency_data *v)
+{
+#ifdef IRQGEN_CONFIG_BATCHES
+    return v->idx;
+#else
+    return 0;
+#endif
+}
+
+/*-
+ * Place of a field of struct latency_data in the records of a channel
+ *
+ * @src: offset in struct latency_data, IRQGEN_CHAN_SRC_SEQ for the
+ *       sequence number of the channel
+ * @dst: offset in the record
+ * @size: size in bytes
+ */
+#define IRQGEN_CHAN_SRC_SEQ 0xFF
+
+struct irqgen_chan_field {
+    u8 src;
+    u8 dst;
+    u8 size;
+};
+
+/*-
+ * Per-line channel: a latency buffer of its own for the samples of one IRQ
+ * line, read through its own device node, so that the samples of a busy
+ * line do not evict the ones of the others. The samples are stored as
+ * records of only the fields selected for the channel.
+ *
+ * @ring: the records, circular buffer of @size elems of @stride bytes
+ *        (NULL if @size is 0)
+ * @size: capacity of @ring, 0 if the channel is disabled
+ * @wp: writing position in @ring
+ * @rp: reading position in @ring
+ * @dropped: count of samples overwritten before being read
+ * @seq: sequence number of the next sample
+ * @fields: mask of the fields in the records, 1 << IRQGEN_FIELD_*
+ * @stride: size in bytes of a record
+ * @nfields: number of entries in @layout
+ * @layout: the fields in the records
+ * @readq: readers of the channel waiting for samples
+ * @opened: whether the device node of the channel is open
+ * @binary: whether the reader gets binary records instead of CSV lines
+ * @hdr_sent: whether the binary reader already got the schema header
+ */
+struct irqgen_chan {
+    u8 *ring;
+    u32 size;
+    u32 wp;
+    u32 rp;
+    u32 dropped;
+    u32 seq;
+    u32 fields;
+    u16 stride;
+    u8 nfields;
+    struct irqgen_chan_field layout[IRQGEN_FIELD_COUNT];
+    wait_queue_head_t readq;
+    bool opened;
+    bool binary;
+    bool hdr_sent;
+};
+
+/*-
+ * Decimation of the samples pushed to the latency buffer, per IRQ line
+ *
+ * @mode: which samples are kept, one of enum irqgen_filter_mode
+ * @param: N for IRQGEN_FILTER_NTH, the probability in parts per million for
+ *         IRQGEN_FILTER_PROB, the latency in clock cycles for
+ *         IRQGEN_FILTER_ABOVE
+ * @prob: @param scaled to the range of a u32, for IRQGEN_FILTER_PROB
+ * @count: IRQs seen since the last kept sample, for IRQGEN_FILTER_NTH
+ * @filtered: count of samples discarded by the filter
+ */
+enum irqgen_filter_mode {
+    IRQGEN_FILTER_ALL = 0,      // keep every sample
+    IRQGEN_FILTER_NTH,          // keep one sample every N
+    IRQGEN_FILTER_PROB,         // keep each sample with a probability
+    IRQGEN_FILTER_ABOVE,        // keep samples above a latency threshold
+};
+
+struct irqgen_filter {
+    u8  mode;
+    u32 param;
+    u32 prob;
+    u32 count;
+    u32 filtered;
+};
+
+/*-
+ * Oscilloscope-style trigger on the latency buffer: once armed, the first
+ * sample matching the condition fires it, @post more samples are recorded,
+ * then the buffer is frozen for the readout through debugfs
+ *
+ * @state: one of enum irqgen_trigger_state
+ * @cond: condition firing the trigger, one of enum irqgen_trigger_cond
+ * @threshold: latency in clock cycles for IRQGEN_TRIGGER_LATENCY
+ * @post: samples to record after the trigger sample
+ * @remaining: post-trigger samples still to record
+ * @pos: position in the latency buffer of the trigger sample
+ * @timestamp: timestamp in ns when the trigger fired
+ * @frozen_drops: count of samples discarded while frozen
+ * @gen: incremented at each (re)arm or disarm, so that readers can detect
+ *       that the frozen buffer was released under their feet
+ */
+enum irqgen_trigger_state {
+    IRQGEN_TRIGGER_IDLE = 0,
+    IRQGEN_TRIGGER_ARMED,
+    IRQGEN_TRIGGER_FIRED,
+    IRQGEN_TRIGGER_FROZEN,
+};
+
+struct irqgen_trigger {
+    u8  state;
+    u8  cond;
+    u32 threshold;
+    u32 post;
+    u32 remaining;
+    int pos;
     u64 timestamp;
+    u32 frozen_drops;
+    u32 gen;
+};
+
+/*-
+ * A generation command, i.e. a batch of IRQs on one line
+ *
+ * @id: ID of the batch, starting from 1
+ * @line: the IRQ line of the batch
+ * @amount: IRQs requested by the command
+ * @delay: IRQ delay requested by the command
+ * @handled: IRQs of the batch handled so far
+ * @issued_ns: timestamp in ns when the command was written
+ * @done_ns: timestamp in ns when the last IRQ of the batch was handled (0
+ *           while in progress, or if the batch was superseded before)
+ */
+struct irqgen_batch {
+    u32 id;
+    u8  line;
+    u32 amount;
+    u16 delay;
+    u32 handled;
+    u64 issued_ns;
+    u64 done_ns;
+};
+
+#define IRQGEN_BATCH_LOG 16         // Finished batches kept for sysfs
+
+/*-
+ * A generation command
+ *
+ * @amount: IRQs to generate
+ * @line: the IRQ line to use
+ * @delay: IRQ delay
+ * @batch: ID of the batch started for the command
+ */
+struct irqgen_cmd {
+    u16 amount;
+    u8  line;
+    u16 delay;
+    u32 batch;
+};
+
+#define IRQGEN_FLOWCTL_LOG 16       // Pauses of the generator kept for sysfs
+
+/*-
+ * An interval during which the flow control paused the generator
+ *
+ * @start_ns: timestamp in ns when the generator was paused
+ * @duration_ns: ns until it was resumed
+ */
+struct irqgen_pause {
+    u64 start_ns;
+    u64 duration_ns;
+};
+
+/*-
+ * Flow control of the generator on the occupancy of the latencies buffer:
+ * the generator is paused when the buffer reaches @high unread samples, and
+ * resumed when the readers bring it down to @low
+ *
+ * @enabled: whether the flow control is active
+ * @paused: whether the generator is paused
+ * @high: high watermark in samples
+ * @low: low watermark in samples
+ * @paused_at: timestamp in ns of the current pause
+ * @pauses: number of pauses
+ * @paused_ns: total ns paused, excluding the current pause
+ * @resume: command to write when resuming (amount 0 if none)
+ * @log: the last pauses, circular buffer
+ * @log_wp: next entry of @log to write
+ */
+struct irqgen_flowctl {
+    bool enabled;
+    bool paused;
+    u32 high;
+    u32 low;
+    u64 paused_at;
+    u32 pauses;
+    u64 paused_ns;
+    struct irqgen_cmd resume;
+    struct irqgen_pause log[IRQGEN_FLOWCTL_LOG];
+    u32 log_wp;
+};
+
+/*-
+ * Closed-loop ping-pong generation: a single IRQ at a time, the next one
+ * being issued by the handler right after the previous one is acknowledged
+ *
+ * @active: whether a ping-pong run is in progress
+ * @line: the IRQ line used by the run
+ * @delay: IRQ delay used for each generated IRQ
+ * @remaining: IRQs still to generate, including the one in flight
+ * @completed: IRQs handled since the run was started
+ */
+struct irqgen_pingpong {
+    bool active;
+    u8  line;
+    u16 delay;
+    u32 remaining;
+    u32 completed;
 };
 
 /*-
@@ -38,10 +302,24 @@ struct latency_data {
  *
  * @intr_handled: count of total handled interrupts per interrupt ID
  * @total_handled: count of total handled interrupts
+ * @filters: per line decimation of the samples (every IRQ is still counted
+ *           in the statistics)
+ * @dropped: count of latency samples overwritten before being read
  * @latencies: circular bugger for IRQ latencies from the IRQ generator;
  *             capacity is MAX_LATENCIES elems
  * @wp: writing position in the latencies buffer
  * @rp: reading position in the latencies buffer
+ * @wrapped: whether @wp went around the latencies buffer at least once
+ * @merged: whether the samples go to the latencies buffer, the merged view
+ *          of all lines read through /dev/irqgen
+ * @chans: per-line channels
+ * @readq: readers of the latencies buffer waiting for samples
+ * @wakeup_threshold: samples in the latencies buffer needed to wake readers
+ * @last_wake_ns: timestamp in ns of the last wakeup of a reader not yet
+ *                followed by a read, 0 if none
+ * @trigger: trigger and freeze of the latencies buffer
+ * @pingpong: state of the ping-pong generation mode
+ * @sample_flags: IRQGEN_SAMPLE_* flags of the samples handled now
  */
 struct irqgen_data {
     int line_count;
@@ -54,13 +332,63 @@ struct irqgen_data {
     /* The members below must be protected from concurrent access */
     u32 *intr_handled;
     u32 total_handled;
+    struct irqgen_filter *filters;
+    u32 dropped;
     struct latency_data *latencies;
     int wp;
     int rp;
+    bool wrapped;
+    bool merged;
+    struct irqgen_chan *chans;
+    wait_queue_head_t readq;
+    u32 wakeup_threshold;
+    u64 last_wake_ns;
+    struct irqgen_trigger trigger;
+    struct irqgen_pingpong pingpong;
+    struct irqgen_batch *batches;
+    struct irqgen_batch batch_log[IRQGEN_BATCH_LOG];
+    u32 batch_log_wp;
+    u32 next_batch;
+    struct irqgen_batch last_done;
+    u32 done_seq;
+    struct irqgen_flowctl flowctl;
+    struct irqgen_stats_page *stats;
+    u8 sample_flags;
 };
 
+#define FPGA_CLOCK_NS   10 /* 1000 / FPGA_CLOCK_MHZ */
+
 #define MAX_LATENCIES 10000         // The maximum number of latencies to store
 
+#define IRQGEN_ROLLUP_SLOTS 60      // Windows kept for each rollup width
+
+// Index of the log2 histogram bin for a value: bin i counts [2^(i-1), 2^i)
+static inline int irqgen_log2_bin(u64 value, int nbins)
+{
+    return min_t(int, fls64(value), nbins - 1);
+}
+
+#define IRQGEN_HIST_BINS 32
+
+/*-
+ * Log2 histogram of a duration, with its count, sum and maximum
+ */
+struct irqgen_hist {
+    u64 count;
+    u64 sum;
+    u64 max;
+    u32 bins[IRQGEN_HIST_BINS];
+};
+
+static inline void irqgen_hist_add(struct irqgen_hist *h, u64 value)
+{
+    ++h->count;
+    h->sum += value;
+    if (value > h->max)
+        h->max = value;
+    ++h->bins[irqgen_log2_bin(value, IRQGEN_HIST_BINS)];
+}
+
 // Kernel token address to access the IRQ Generator core register
 extern void __iomem *irqgen_reg_base;
 #include "irqgen_addresses.h"       // Device specific addresses
@@ -68,16 +396,380 @@ extern void __iomem *irqgen_reg_base;
 // Module data instance
 extern struct irqgen_data *irqgen_data;
 
+/*
+ * Optional features, selected at build time (see the Makefile):
+ *
+ * IRQGEN_CONFIG_SAMPLES: the latencies buffer and its readers: /dev/irqgen,
+ *                        the per-line channels, the filter, the trigger, the
+ *                        pipeline latency, the flow control and the
+ *                        measurement session
+ * IRQGEN_CONFIG_BATCHES: the generation batches, their completion
+ *                        notification and the submission ring
+ * IRQGEN_CONFIG_STATS: the rollups, the handler profile, the PMU counters,
+ *                      the stats page and the affinity balancer
+ * IRQGEN_CONFIG_TRACE: the tracepoints and the in-kernel consumers
+ *
+ * The hooks of a feature left out are empty inlines below, so that the
+ * handler of a build without any only acks and counts the IRQs.
+ */
+
 void enable_irq_generator(void);
 void disable_irq_generator(void);
 void do_generate_irqs(uint16_t amount, uint8_t line, uint16_t delay);
+void irqgen_issue(const struct irqgen_cmd *c);
+int irqgen_pingpong_start(u8 line, u16 delay, u32 iterations);
+void irqgen_pingpong_stop(void);
 u64 irqgen_read_latency(void);
 u32 irqgen_read_count(void);
 
 int irqgen_sysfs_setup(struct platform_device *pdev);
+void irqgen_sysfs_notify(const char *attr);
 void irqgen_sysfs_cleanup(struct platform_device *pdev);
 
+int irqgen_calib_setup(struct platform_device *pdev);
+int irqgen_calib_run(void);
+u32 irqgen_calib_baseline(void);
+void irqgen_calib_set_correct(bool correct);
+ssize_t irqgen_calib_show(char *buf);
+
+int irqgen_debugfs_setup(struct platform_device *pdev);
+void irqgen_debugfs_cleanup(struct platform_device *pdev);
+
+/*-
+ * Content of a debugfs file captured at open() time, so that it stays
+ * consistent however it gets split in reads
+ *
+ * @size: size in bytes of @data
+ * @data: the content of the file
+ */
+struct irqgen_snapshot {
+    size_t size;
+    char data[];
+};
+
+struct seq_file;
+void irqgen_hist_show(struct seq_file *m, const char *name, const struct irqgen_hist *h);
+
+struct irqgen_snapshot *irqgen_snapshot_alloc(size_t size);
+ssize_t irqgen_snapshot_read(struct file *f, char __user *ubuf, size_t count, loff_t *ppos);
+int irqgen_snapshot_release(struct inode *inode, struct file *f);
+
+struct vm_area_struct;
+struct bin_attribute;
+struct class;
+struct kobject;
+
+/* ---- IRQGEN_CONFIG_SAMPLES ---- */
+#ifdef IRQGEN_CONFIG_SAMPLES
+
+// Number of unread samples in the latencies buffer
+static inline int irqgen_data_pending(void)
+{
+    return (irqgen_data->wp - irqgen_data->rp + MAX_LATENCIES) % MAX_LATENCIES;
+}
+
+bool __irqgen_filter_keep(struct irqgen_filter *f, u32 latency);
+
+// Whether the sample of a handled IRQ goes to the latency buffer: runs
+// inside the critical section of the interrupt handler
+static inline bool irqgen_filter_keep(int line, u32 latency)
+{
+    struct irqgen_filter *f = &irqgen_data->filters[line];
+
+    if (likely(f->mode == IRQGEN_FILTER_ALL))
+        return true;
+    return __irqgen_filter_keep(f, latency);
+}
+
+int irqgen_filter_set(int line, const char *mode, u32 param);
+ssize_t irqgen_filter_show(char *buf);
+
+bool __irqgen_trigger_keep(u64 timestamp, u32 latency, bool keep);
+
+// Whether the sample of a handled IRQ goes to the latency buffer once the
+// trigger is armed: may force a filtered trigger sample in, or keep
+// everything out while frozen. Runs inside the critical section of the
+// interrupt handler.
+static inline bool irqgen_trigger_keep(u64 timestamp, u32 latency, bool keep)
+{
+    if (likely(irqgen_data->trigger.state == IRQGEN_TRIGGER_IDLE))
+        return keep;
+    return __irqgen_trigger_keep(timestamp, latency, keep);
+}
+
+int irqgen_trigger_set(const char *cmd, u32 param);
+int irqgen_trigger_set_post(u32 post);
+ssize_t irqgen_trigger_show(char *buf);
+extern const struct file_operations irqgen_capture_fops;
+
+void irqgen_pipeline_woken(u64 now);
+void irqgen_pipeline_consumed(const struct latency_data *s, u64 now);
+extern const struct file_operations irqgen_pipeline_fops;
+
+u32 irqgen_chan_backlog(void);
+
+// Samples waiting for a reader, checked against the watermarks: in the
+// merged ring if it is on, and in each open channel. Runs with the
+// data_lock held.
+static inline u32 irqgen_flowctl_backlog(void)
+{
+    u32 n = irqgen_data->merged ? irqgen_data_pending() : 0;
+
+    return max(n, irqgen_chan_backlog());
+}
+
+void __irqgen_flowctl_pause(int line, u64 now, struct irqgen_cmd *next, bool pingpong);
+// Pause the generator if the backlog reached the high watermark: runs
+// inside the critical section of the interrupt handler
+static inline bool irqgen_flowctl_check(int line, u64 now, struct irqgen_cmd *next,
+                                        bool pingpong)
+{
+    const struct irqgen_flowctl *fc = &irqgen_data->flowctl;
+
+    if (likely(!fc->enabled) || fc->paused || irqgen_flowctl_backlog() < fc->high)
+        return false;
+
+    __irqgen_flowctl_pause(line, now, next, pingpong);
+    return true;
+}
+bool irqgen_flowctl_resume(struct irqgen_cmd *cmd, bool force);
+int irqgen_flowctl_set(u32 high, u32 low);
+ssize_t irqgen_flowctl_show(char *buf);
+
+int irqgen_session_setup(struct platform_device *pdev);
+void irqgen_session_cleanup(struct platform_device *pdev);
+int irqgen_session_start(s32 latency_us, bool pin, struct file *owner);
+void irqgen_session_stop(struct file *owner);
+ssize_t irqgen_session_show(char *buf);
+
+bool __irqgen_chan_push(struct irqgen_chan *c, const struct latency_data *s);
+
+// Push a sample to the channel of its line, if enabled: runs inside the
+// critical section of the interrupt handler.
+// Returns whether readers of the channel have to be woken up.
+static inline bool irqgen_chan_push(int line, const struct latency_data *s)
+{
+    struct irqgen_chan *c = &irqgen_data->chans[line];
+
+    if (likely(0 == c->size))
+        return false;
+    return __irqgen_chan_push(c, s);
+}
+
+static inline bool irqgen_chan_active(int line)
+{
+    return 0 != irqgen_data->chans[line].size;
+}
+
+int irqgen_chan_setup(struct platform_device *pdev, struct class *class);
+void irqgen_chan_cleanup(struct platform_device *pdev, struct class *class);
+int irqgen_chan_resize(int line, u32 size, u32 fields);
+ssize_t irqgen_chan_show(char *buf);
+
+int irqgen_sample_format(char *buf, size_t size, const struct latency_data *v);
+
 int irqgen_cdev_setup(struct platform_device *pdev);
 void irqgen_cdev_cleanup(struct platform_device *pdev);
 
+#else /* !IRQGEN_CONFIG_SAMPLES: no latencies buffer */
+
+static inline int irqgen_data_pending(void) { return 0; }
+static inline bool irqgen_filter_keep(int line, u32 latency) { return false; }
+static inline bool irqgen_trigger_keep(u64 timestamp, u32 latency, bool keep) { return keep; }
+static inline bool irqgen_chan_push(int line, const struct latency_data *s) { return false; }
+static inline bool irqgen_chan_active(int line) { return false; }
+static inline bool irqgen_flowctl_check(int line, u64 now, struct irqgen_cmd *next,
+                                        bool pingpong) { return false; }
+static inline bool irqgen_flowctl_resume(struct irqgen_cmd *cmd, bool force) { return false; }
+static inline int irqgen_session_setup(struct platform_device *pdev) { return 0; }
+static inline void irqgen_session_cleanup(struct platform_device *pdev) {}
+static inline int irqgen_cdev_setup(struct platform_device *pdev) { return 0; }
+static inline void irqgen_cdev_cleanup(struct platform_device *pdev) {}
+
+#endif /* IRQGEN_CONFIG_SAMPLES */
+
+/* ---- IRQGEN_CONFIG_BATCHES ---- */
+#ifdef IRQGEN_CONFIG_BATCHES
+
+u32 irqgen_batch_next(int line, u64 timestamp, u32 *idx, struct irqgen_cmd *next);
+u32 irqgen_batch_start(u8 line, u32 amount, u16 delay);
+u32 __irqgen_batch_start(u8 line, u32 amount, u16 delay);
+ssize_t irqgen_batch_show(char *buf);
+
+int irqgen_notify_setup(struct platform_device *pdev);
+void irqgen_notify_done(const struct irqgen_batch *b);
+int irqgen_notify_set_eventfd(int fd);
+
+int irqgen_ring_setup(struct platform_device *pdev);
+bool irqgen_ring_done(const struct irqgen_batch *b, struct irqgen_cmd *next);
+void irqgen_ring_superseded(const struct irqgen_batch *b);
+void irqgen_ring_stop(void);
+int irqgen_ring_enter(void);
+int irqgen_ring_mmap(struct file *f, struct vm_area_struct *vma);
+
+#else /* !IRQGEN_CONFIG_BATCHES: IRQs are not tied to their command */
+
+static inline u32 irqgen_batch_next(int line, u64 timestamp, u32 *idx,
+                                    struct irqgen_cmd *next) { *idx = 0; return 0; }
+static inline u32 irqgen_batch_start(u8 line, u32 amount, u16 delay) { return 0; }
+static inline int irqgen_notify_setup(struct platform_device *pdev) { return 0; }
+static inline int irqgen_notify_set_eventfd(int fd) { return -EOPNOTSUPP; }
+static inline int irqgen_ring_setup(struct platform_device *pdev) { return 0; }
+static inline void irqgen_ring_stop(void) {}
+static inline int irqgen_ring_enter(void) { return -EOPNOTSUPP; }
+static inline int irqgen_ring_mmap(struct file *f, struct vm_area_struct *vma) { return -ENODEV; }
+
+#endif /* IRQGEN_CONFIG_BATCHES */
+
+/* ---- IRQGEN_CONFIG_STATS ---- */
+#ifdef IRQGEN_CONFIG_STATS
+
+void __irqgen_hprof_account(u64 ns);
+
+// Handler self-time profiler: irqgen_hprof_enter() is the first thing the
+// interrupt handler does, irqgen_hprof_exit() the last one. local_clock()
+// rather than get_cycles(), which is 0 on ARM without a timer-based delay.
+static inline u64 irqgen_hprof_enter(void)
+{
+    if (static_branch_likely(&irqgen_instr_key))
+        return local_clock();
+    return 0;
+}
+
+static inline void irqgen_hprof_exit(u64 entry)
+{
+    if (static_branch_likely(&irqgen_instr_key) && entry)
+        __irqgen_hprof_account(local_clock() - entry);
+}
+
+extern const struct file_operations irqgen_hprof_fops;
+
+#endif /* IRQGEN_CONFIG_STATS */
+
+#define IRQGEN_PMU_EVENTS 3         // instructions, cache misses, branch misses
+#define IRQGEN_PMU_BINS 16
+
+#ifdef IRQGEN_CONFIG_STATS
+
+// Hardware PMU counters read around the handler, off until enabled
+// through sysfs since the counters have to be created first
+DECLARE_STATIC_KEY_FALSE(irqgen_pmu_key);
+
+void __irqgen_pmu_enter(u64 *values);
+void __irqgen_pmu_exit(int line, const u64 *values);
+
+// Returns whether the counters were read, to be passed to irqgen_pmu_exit():
+// the static key may flip in between
+static inline bool irqgen_pmu_enter(u64 *values)
+{
+    if (static_branch_unlikely(&irqgen_pmu_key)) {
+        __irqgen_pmu_enter(values);
+        return true;
+    }
+    return false;
+}
+
+static inline void irqgen_pmu_exit(bool sampled, int line, const u64 *values)
+{
+    if (sampled)
+        __irqgen_pmu_exit(line, values);
+}
+
+int irqgen_pmu_setup(struct platform_device *pdev);
+void irqgen_pmu_cleanup(struct platform_device *pdev);
+int irqgen_pmu_enable(void);
+void irqgen_pmu_disable(void);
+bool irqgen_pmu_is_enabled(void);
+extern const struct file_operations irqgen_pmu_fops;
+
+/*
+ * Publish a handled IRQ in the stats page: runs inside the critical section
+ * of the interrupt handler, which serializes the writers of the page
+ */
+static inline void irqgen_stats_update(int line, u32 latency, u64 timestamp, int evicted)
+{
+    struct irqgen_stats_page *p = irqgen_data->stats;
+    struct irqgen_stats_line *l = &p->lines[line];
+
+    WRITE_ONCE(p->seq, p->seq + 1);
+    smp_wmb();
+    p->total_handled = irqgen_data->total_handled;
+    p->dropped = irqgen_data->dropped;
+    ++l->handled;
+    l->last_latency = latency;
+    l->last_ns = timestamp;
+    if (evicted >= 0)
+        ++p->lines[evicted].dropped;
+    smp_wmb();
+    WRITE_ONCE(p->seq, p->seq + 1);
+}
+int irqgen_stats_setup(struct platform_device *pdev);
+ssize_t irqgen_stats_read(struct file *f, struct kobject *kobj, struct bin_attribute *attr,
+                          char *buf, loff_t off, size_t count);
+int irqgen_stats_mmap(struct file *f, struct kobject *kobj, struct bin_attribute *attr,
+                      struct vm_area_struct *vma);
+
+int irqgen_rollup_setup(struct platform_device *pdev);
+void irqgen_rollup_account(int line, u32 latency, u64 timestamp, int evicted);
+extern const struct file_operations irqgen_rollup_fops;
+
+// Affinity balancer moving the IRQ lines to the CPU with the best p99
+// latency, off until started through sysfs
+DECLARE_STATIC_KEY_FALSE(irqgen_balance_key);
+
+void __irqgen_balance_account(int line, int cpu, u32 latency);
+
+// Runs inside the critical section of the interrupt handler
+static inline void irqgen_balance_account(int line, int cpu, u32 latency)
+{
+    if (static_branch_unlikely(&irqgen_balance_key))
+        __irqgen_balance_account(line, cpu, latency);
+}
+
+int irqgen_balance_setup(struct platform_device *pdev);
+void irqgen_balance_cleanup(struct platform_device *pdev);
+int irqgen_balance_set(unsigned int period_ms, unsigned int hysteresis);
+ssize_t irqgen_balance_show(char *buf);
+
+#else /* !IRQGEN_CONFIG_STATS: no statistics beyond the counters */
+
+static inline u64 irqgen_hprof_enter(void) { return 0; }
+static inline void irqgen_hprof_exit(u64 entry) {}
+static inline bool irqgen_pmu_enter(u64 *values) { return false; }
+static inline void irqgen_pmu_exit(bool sampled, int line, const u64 *values) {}
+static inline int irqgen_pmu_setup(struct platform_device *pdev) { return 0; }
+static inline void irqgen_pmu_cleanup(struct platform_device *pdev) {}
+static inline void irqgen_stats_update(int line, u32 latency, u64 timestamp, int evicted) {}
+static inline int irqgen_stats_setup(struct platform_device *pdev) { return 0; }
+static inline int irqgen_rollup_setup(struct platform_device *pdev) { return 0; }
+static inline void irqgen_rollup_account(int line, u32 latency, u64 timestamp, int evicted) {}
+static inline void irqgen_balance_account(int line, int cpu, u32 latency) {}
+static inline int irqgen_balance_setup(struct platform_device *pdev) { return 0; }
+static inline void irqgen_balance_cleanup(struct platform_device *pdev) {}
+
+#endif /* IRQGEN_CONFIG_STATS */
+
+/* ---- IRQGEN_CONFIG_TRACE ---- */
+struct irqgen_event;
+
+#ifdef IRQGEN_CONFIG_TRACE
+
+// In-kernel consumers of the events, see irqgen_consumer.h: the handler
+// skips the dispatch while none is registered
+DECLARE_STATIC_KEY_FALSE(irqgen_consumer_key);
+
+void __irqgen_consumers_dispatch(const struct irqgen_event *e);
+
+static inline bool irqgen_consumers_active(void)
+{
+    return static_branch_unlikely(&irqgen_consumer_key);
+}
+
+#else /* !IRQGEN_CONFIG_TRACE: no tracepoints nor consumers */
+
+static inline bool irqgen_consumers_active(void) { return false; }
+static inline void __irqgen_consumers_dispatch(const struct irqgen_event *e) {}
+
+#endif /* IRQGEN_CONFIG_TRACE */
+
 #endif /* !defined(__IRQGEN_HEADER) */
@@ -16,6 +16,21 @@
 # define IRQGEN_IRQ_COUNT_REG (irqgen_reg_base + IRQGEN_IRQ_COUNT_REG_OFFSET)
 # define IRQGEN_LATENCY_REG   (irqgen_reg_base + IRQGEN_LATENCY_REG_OFFSET)
 
+/*
+ * Register accessors: with IRQGEN_CONFIG_EMUL the registers are the ones of
+ * the emulated device of irqgen_emul.ko, for machines without the FPGA
+ */
+#ifdef IRQGEN_CONFIG_EMUL
+u32 irqgen_emul_read(void __iomem *addr);
+void irqgen_emul_write(u32 value, void __iomem *addr);
+void __iomem *irqgen_emul_regs(void);
+# define irqgen_ioread32(_addr)         irqgen_emul_read(_addr)
+# define irqgen_iowrite32(_val, _addr)  irqgen_emul_write((_val), (_addr))
+#else
+# define irqgen_ioread32(_addr)         ioread32(_addr)
+# define irqgen_iowrite32(_val, _addr)  iowrite32((_val), (_addr))
+#endif
+
 /* --- bitfield defines for HW registers' fields --- */
 # include <linux/bitfield.h>         // bitfield macros for writing the HW registers
 
@@ -0,0 +1,317 @@
+/**
+ * @file   irqgen_balance.c
+ * @date   17 October 2026
+ * @target_device Xilinx PYNQ-Z1
+ * @brief   Latency-driven IRQ affinity balancer of irqgen.ko: moves the
+ *          IRQ lines towards the CPUs that handle them fastest.
+ */
+
+# include <linux/kernel.h>           // Contains types, macros, functions for the kernel
+# include <linux/slab.h>             // kcalloc
+# include <linux/cpumask.h>          // cpumask_of, online CPUs
+# include <linux/interrupt.h>        // irq_set_affinity_hint
+# include <linux/workqueue.h>        // Periodic balancing pass
+# include <linux/mutex.h>
+# include <linux/ktime.h>            // ktime_get_ns
+
+# include "irqgen.h"                 // Shared module specific declarations
+
+#ifndef IRQGEN_CONFIG_TRACE
+#define NOTRACE
+#endif
+# include "irqgen_trace.h"           // trace_irqgen_migrate
+
+/*
+ * Every period the balancer computes the p99 latency of the IRQs handled by
+ * each CPU during the period, and moves at most one IRQ line from the CPU
+ * handling it to the CPU with the lowest p99, if that is lower by more than
+ * the hysteresis. A line just moved stays where it is for
+ * IRQGEN_BALANCE_HOLD periods.
+ * A CPU which handled too few IRQs in a period keeps its previous p99,
+ * decayed by 1/8 each period (a CPU never measured has 0): a CPU left
+ * without lines eventually looks the best one, gets a line back and is
+ * measured again.
+ */
+#define IRQGEN_BALANCE_MIN_SAMPLES 64
+#define IRQGEN_BALANCE_HOLD 3
+#define IRQGEN_BALANCE_LOG 16
+
+DEFINE_STATIC_KEY_FALSE(irqgen_balance_key);
+
+// Latency histogram with 4 bins per power of 2, fine enough for a p99
+#define BALANCE_BINS 64
+
+static inline int balance_bin(u32 v)
+{
+    int e;
+
+    if (v < 4)
+        return v;
+    e = fls(v) - 1;
+    return min_t(int, ((e - 1) << 2) | ((v >> (e - 2)) & 3), BALANCE_BINS - 1);
+}
+
+// Smallest value counted by a bin
+static inline u32 balance_bin_low(int b)
+{
+    if (b < 4)
+        return b;
+    return (4 | (b & 3)) << ((b >> 2) - 1);
+}
+
+/*-
+ * Latencies of the IRQs handled by one CPU during the current period
+ *
+ * @count: number of IRQs
+ * @bins: histogram of the latencies, see balance_bin()
+ */
+struct irqgen_balance_win {
+    u32 count;
+    u32 bins[BALANCE_BINS];
+};
+
+/*-
+ * A migration of an IRQ line
+ *
+ * @ns: timestamp in ns of the migration
+ * @line: the IRQ line moved
+ * @from: the CPU which was handling the line
+ * @to: the CPU now handling the line
+ * @p99_from: p99 latency of @from, in clock cycles
+ * @p99_to: p99 latency of @to, in clock cycles
+ */
+struct irqgen_migration {
+    u64 ns;
+    u8  line;
+    u8  from;
+    u8  to;
+    u32 p99_from;
+    u32 p99_to;
+};
+
+/* The windows and last_cpu are protected by irqgen_data->data_lock */
+static struct irqgen_balance_win *balance_win = NULL;
+static int *balance_last_cpu = NULL;
+
+/* The members below are protected by irqgen_balance_mutex */
+static DEFINE_MUTEX(irqgen_balance_mutex);
+static struct irqgen_balance_win *balance_copy = NULL;
+static u32 *balance_p99 = NULL;         // per CPU, 0 if never measured
+static u32 *balance_samples = NULL;     // per CPU, in the last period
+static int *balance_hold = NULL;        // per line, periods left before a move
+static unsigned int balance_period_ms = 0;      // 0 if the balancer is off
+static unsigned int balance_hysteresis = 20;    // percent
+static u32 balance_migrations = 0;
+static struct irqgen_migration balance_log[IRQGEN_BALANCE_LOG];
+static int balance_log_wp = 0;
+
+static void balance_work_fn(struct work_struct *work);
+static DECLARE_DELAYED_WORK(balance_work, balance_work_fn);
+
+// Account a handled IRQ: runs inside the critical section of the interrupt
+// handler
+void __irqgen_balance_account(int line, int cpu, u32 latency)
+{
+    struct irqgen_balance_win *w = &balance_win[cpu];
+
+    ++w->count;
+    ++w->bins[balance_bin(latency)];
+    balance_last_cpu[line] = cpu;
+}
+
+// Upper bound of the bin holding the 99th percentile
+static u32 balance_win_p99(const struct irqgen_balance_win *w)
+{
+    u32 rank = w->count - w->count / 100, seen = 0;
+    int b;
+
+    for (b = 0; b < BALANCE_BINS - 1; ++b) {
+        seen += w->bins[b];
+        if (seen >= rank)
+            break;
+    }
+    return b < BALANCE_BINS - 1 ? balance_bin_low(b + 1) - 1 : balance_bin_low(b);
+}
+
+static void balance_move(int line, int from, int to)
+{
+    struct irqgen_migration *m = &balance_log[balance_log_wp];
+    unsigned int irq = irqgen_data->intr_ids[line];
+    int retval;
+
+    retval = irq_set_affinity_hint(irq, cpumask_of(to));
+    if (0 != retval) {
+        printk_ratelimited(KERN_WARNING KMSG_PFX
+                           "Moving IRQ %u to CPU %d failed with %d.\n", irq, to, retval);
+        return;
+    }
+
+    m->ns = ktime_get_ns();
+    m->line = line;
+    m->from = from;
+    m->to = to;
+    m->p99_from = balance_p99[from];
+    m->p99_to = balance_p99[to];
+    balance_log_wp = (balance_log_wp + 1) % IRQGEN_BALANCE_LOG;
+    ++balance_migrations;
+    balance_hold[line] = IRQGEN_BALANCE_HOLD;
+
+    trace_irqgen_migrate(line, irq, from, to, m->p99_from, m->p99_to);
+}
+
+// One balancing pass, with irqgen_balance_mutex held
+static void balance_pass(void)
+{
+    int cpu, line, best = -1, move = -1, from = -1;
+    int *last_cpu;
+    u32 margin = 0;
+
+    last_cpu = kcalloc(irqgen_data->line_count, sizeof(*last_cpu), GFP_KERNEL);
+    if (NULL == last_cpu)
+        return;
+
+    // Keep the interrupts off only for the raw copy of the windows
+    spin_lock_irq(&irqgen_data->data_lock);
+    memcpy(balance_copy, balance_win, nr_cpu_ids * sizeof(*balance_win));
+    memset(balance_win, 0, nr_cpu_ids * sizeof(*balance_win));
+    memcpy(last_cpu, balance_last_cpu, irqgen_data->line_count * sizeof(*last_cpu));
+    spin_unlock_irq(&irqgen_data->data_lock);
+
+    for_each_possible_cpu(cpu) {
+        const struct irqgen_balance_win *w = &balance_copy[cpu];
+
+        balance_samples[cpu] = w->count;
+        if (w->count >= IRQGEN_BALANCE_MIN_SAMPLES)
+            balance_p99[cpu] = balance_win_p99(w);
+        else
+            balance_p99[cpu] -= balance_p99[cpu] / 8;
+
+        if (cpu_online(cpu) && (best < 0 || balance_p99[cpu] < balance_p99[best]))
+            best = cpu;
+    }
+
+    // The line to move is the one on the CPU with the worst p99
+    for (line = 0; line < irqgen_data->line_count; ++line) {
+        int cur = last_cpu[line];
+
+        if (balance_hold[line] > 0) {
+            --balance_hold[line];
+            continue;
+        }
+        if (cur < 0 || cur == best || balance_p99[cur] <= balance_p99[best])
+            continue;
+        if ((u64)balance_p99[best] * 100 >=
+            (u64)balance_p99[cur] * (100 - balance_hysteresis))
+            continue;
+        if (balance_p99[cur] - balance_p99[best] > margin) {
+            margin = balance_p99[cur] - balance_p99[best];
+            move = line;
+            from = cur;
+        }
+    }
+
+    if (move >= 0)
+        balance_move(move, from, best);
+    kfree(last_cpu);
+}
+
+static void balance_work_fn(struct work_struct *work)
+{
+    mutex_lock(&irqgen_balance_mutex);
+    if (0 != balance_period_ms) {
+        balance_pass();
+        schedule_delayed_work(&balance_work, msecs_to_jiffies(balance_period_ms));
+    }
+    mutex_unlock(&irqgen_balance_mutex);
+}
+
+// Start the balancer with the given period in ms and hysteresis in percent,
+// or stop it with a period of 0
+int irqgen_balance_set(unsigned int period_ms, unsigned int hysteresis)
+{
+    if (hysteresis >= 100)
+        return -EINVAL;
+
+    mutex_lock(&irqgen_balance_mutex);
+    balance_hysteresis = hysteresis;
+    if (0 != period_ms && 0 == balance_period_ms) {
+        memset(balance_hold, 0, irqgen_data->line_count * sizeof(*balance_hold));
+        spin_lock_irq(&irqgen_data->data_lock);
+        memset(balance_win, 0, nr_cpu_ids * sizeof(*balance_win));
+        spin_unlock_irq(&irqgen_data->data_lock);
+        static_branch_enable(&irqgen_balance_key);
+        schedule_delayed_work(&balance_work, msecs_to_jiffies(period_ms));
+    } else if (0 == period_ms && 0 != balance_period_ms) {
+        // A pass already running sees the period at 0 and stops there
+        static_branch_disable(&irqgen_balance_key);
+        cancel_delayed_work(&balance_work);
+    }
+    balance_period_ms = period_ms;
+    mutex_unlock(&irqgen_balance_mutex);
+
+    return 0;
+}
+
+/*
+ * "<period ms> <hysteresis %> <migrations>", then "cpu<N> <p99> <IRQs>" for
+ * the last period and "<ns> <line> <from> <to> <p99 from> <p99 to>" for the
+ * last migrations, oldest first
+ */
+ssize_t irqgen_balance_show(char *buf)
+{
+    ssize_t len;
+    int cpu, i;
+
+    mutex_lock(&irqgen_balance_mutex);
+    len = scnprintf(buf, PAGE_SIZE, "%u %u %u\n",
+                    balance_period_ms, balance_hysteresis, balance_migrations);
+    for_each_online_cpu(cpu)
+        len += scnprintf(buf + len, PAGE_SIZE - len, "cpu%d %u %u\n",
+                         cpu, balance_p99[cpu], balance_samples[cpu]);
+    for (i = 0; i < IRQGEN_BALANCE_LOG; ++i) {
+        const struct irqgen_migration *m =
+            &balance_log[(balance_log_wp + i) % IRQGEN_BALANCE_LOG];
+
+        if (0 == m->ns)
+            continue;
+        len += scnprintf(buf + len, PAGE_SIZE - len, "%llu %u %u %u %u %u\n",
+                         m->ns, m->line, m->from, m->to, m->p99_from, m->p99_to);
+    }
+    mutex_unlock(&irqgen_balance_mutex);
+
+    return len;
+}
+
+#define BALANCE_DEVM_KCALLOC(_var,_pdev,_cnt) \
+    do { \
+        _var = devm_kcalloc(&(_pdev)->dev, _cnt, sizeof(*_var), GFP_KERNEL); \
+        if (NULL == _var) \
+            return -ENOMEM; \
+    } while (0)
+
+int irqgen_balance_setup(struct platform_device *pdev)
+{
+    int line;
+
+    BALANCE_DEVM_KCALLOC(balance_win, pdev, nr_cpu_ids);
+    BALANCE_DEVM_KCALLOC(balance_copy, pdev, nr_cpu_ids);
+    BALANCE_DEVM_KCALLOC(balance_p99, pdev, nr_cpu_ids);
+    BALANCE_DEVM_KCALLOC(balance_samples, pdev, nr_cpu_ids);
+    BALANCE_DEVM_KCALLOC(balance_last_cpu, pdev, irqgen_data->line_count);
+    BALANCE_DEVM_KCALLOC(balance_hold, pdev, irqgen_data->line_count);
+
+    for (line = 0; line < irqgen_data->line_count; ++line)
+        balance_last_cpu[line] = -1;
+    return 0;
+}
+
+// Stop the balancer and drop the affinity hints before the IRQs are released
+void irqgen_balance_cleanup(struct platform_device *pdev)
+{
+    int line;
+
+    irqgen_balance_set(0, balance_hysteresis);
+    cancel_delayed_work_sync(&balance_work);
+    for (line = 0; line < irqgen_data->line_count; ++line)
+        irq_set_affinity_hint(irqgen_data->intr_ids[line], NULL);
+}
@@ -0,0 +1,133 @@
+/**
+ * @file   irqgen_batch.c
+ * @date   17 October 2026
+ * @target_device Xilinx PYNQ-Z1
+ * @brief   Generation batches of irqgen.ko: batch IDs of the generation
+ *          commands, and the completion of each batch.
+ */
+
+# include <linux/kernel.h>           // Contains types, macros, functions for the kernel
+# include <linux/slab.h>             // Kernel slab allocator
+# include <linux/ktime.h>            // ktime_get_ns
+
+# include "irqgen.h"                 // Shared module specific declarations
+
+// Keep a finished or superseded batch in the log: runs with the data_lock
+// held
+static void irqgen_batch_retire(const struct irqgen_batch *b)
+{
+    irqgen_data->batch_log[irqgen_data->batch_log_wp] = *b;
+    irqgen_data->batch_log_wp = (irqgen_data->batch_log_wp + 1) % IRQGEN_BATCH_LOG;
+}
+
+// Account a handled IRQ to the current batch of its line: runs inside the
+// critical section of the interrupt handler.
+// Returns the ID of the batch, and stores the index of the IRQ in it. If
+// the batch completed and the submission ring has a next command, it is
+// stored in `next`.
+u32 irqgen_batch_next(int line, u64 timestamp, u32 *idx, struct irqgen_cmd *next)
+{
+    struct irqgen_batch *b = &irqgen_data->batches[line];
+
+    *idx = b->handled++;
+    if (b->handled == b->amount) {
+        b->done_ns = timestamp;
+        irqgen_batch_retire(b);
+        irqgen_notify_done(b);
+        irqgen_ring_done(b, next);
+    }
+
+    return b->id;
+}
+
+/*
+ * Start a new batch of `amount` IRQs on `line`, before the command is
+ * written: the batch in progress on the line, if any, is logged unfinished.
+ * Returns the ID of the new batch, or 0 if `line` is out of range.
+ */
+u32 irqgen_batch_start(u8 line, u32 amount, u16 delay)
+{
+    unsigned long flags;
+    u32 id;
+
+    if (line >= irqgen_data->line_count)
+        return 0;
+
+    spin_lock_irqsave(&irqgen_data->data_lock, flags);
+    id = __irqgen_batch_start(line, amount, delay);
+    spin_unlock_irqrestore(&irqgen_data->data_lock, flags);
+
+    return id;
+}
+
+// As irqgen_batch_start(), with the data_lock held and a valid `line`
+u32 __irqgen_batch_start(u8 line, u32 amount, u16 delay)
+{
+    struct irqgen_batch *b = &irqgen_data->batches[line];
+    u32 id;
+
+    if (0 != b->id && b->handled < b->amount) {
+        irqgen_batch_retire(b);
+        irqgen_ring_superseded(b);
+    }
+
+    // 0 is never used as an ID, it marks the IRQs of no batch
+    if (0 == ++irqgen_data->next_batch)
+        ++irqgen_data->next_batch;
+    id = irqgen_data->next_batch;
+
+    b->id = id;
+    b->line = line;
+    b->amount = amount;
+    b->delay = delay;
+    b->handled = 0;
+    b->issued_ns = ktime_get_ns();
+    b->done_ns = 0;
+
+    return id;
+}
+
+/*
+ * Print the batches, one per line as
+ * "<id> <line> <amount> <handled> <issued ns> <completion ns>": the logged
+ * ones from the oldest, then the current one of each line. The completion
+ * time is the time from issue to the last IRQ handled, or -1 if the batch
+ * did not complete.
+ */
+ssize_t irqgen_batch_show(char *buf)
+{
+    struct irqgen_batch *b, *log;
+    int i, n, count = irqgen_data->line_count;
+    ssize_t len = 0;
+
+    b = kmalloc_array(IRQGEN_BATCH_LOG + count, sizeof(*b), GFP_KERNEL);
+    if (NULL == b)
+        return -ENOMEM;
+    log = b + count;
+
+    spin_lock_irq(&irqgen_data->data_lock);
+    for (i = 0; i < IRQGEN_BATCH_LOG; ++i)
+        log[i] = irqgen_data->batch_log[(irqgen_data->batch_log_wp + i) % IRQGEN_BATCH_LOG];
+    memcpy(b, irqgen_data->batches, count * sizeof(*b));
+    spin_unlock_irq(&irqgen_data->data_lock);
+
+    for (i = 0, n = count + IRQGEN_BATCH_LOG; i < n; ++i) {
+        // The logged batches first
+        int k = (count + i) % n;
+        const struct irqgen_batch *e = &b[k];
+
+        // A current batch already logged if it has completed
+        if (0 == e->id || (k < count && 0 != e->done_ns))
+            continue;
+        if (0 != e->done_ns)
+            len += scnprintf(buf + len, PAGE_SIZE - len, "%u %u %u %u %llu %llu\n",
+                             e->id, e->line, e->amount, e->handled, e->issued_ns,
+                             e->done_ns - e->issued_ns);
+        else
+            len += scnprintf(buf + len, PAGE_SIZE - len, "%u %u %u %u %llu -1\n",
+                             e->id, e->line, e->amount, e->handled, e->issued_ns);
+    }
+    kfree(b);
+
+    return len;
+}
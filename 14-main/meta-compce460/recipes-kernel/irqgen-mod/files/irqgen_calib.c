@@ -0,0 +1,180 @@
+/**
+ * @file   irqgen_calib.c
+ * @date   17 October 2026
+ * @target_device Xilinx PYNQ-Z1
+ * @brief   Probe-time calibration of irqgen.ko: estimates the cost of the
+ *          register accesses included in the measured latencies.
+ */
+
+# include <linux/kernel.h>           // Contains types, macros, functions for the kernel
+# include <linux/irqflags.h>         // local_irq_save
+# include <linux/mutex.h>
+# include <linux/math64.h>           // 64-bit divisions
+# include <linux/ktime.h>            // ktime_get_ns
+# include <asm/io.h>                 // IO operations
+
+# include "irqgen.h"                 // Shared module specific declarations
+
+/*
+ * The latency reported by the IRQ Generator runs until the ack write reaches
+ * it, so it includes the AXI round trip of the control register read the
+ * handler does before acking, and the ack write itself. The calibration
+ * measures these costs with the generation disabled: each operation is
+ * timed over CALIB_ITERATIONS iterations with the interrupts off, and the
+ * fastest of CALIB_ROUNDS rounds is kept as the least disturbed one.
+ */
+#define CALIB_ITERATIONS 1024
+#define CALIB_ROUNDS 16
+
+/*-
+ * Results of the last calibration, costs in ps per operation
+ *
+ * @runs: calibrations done, 0 if none
+ * @read_ps: ioread32() of a register of the IRQ Generator
+ * @write_ps: iowrite32() to a register of the IRQ Generator
+ * @timestamp_ps: ktime_get_ns()
+ * @lock_ps: lock and unlock of data_lock
+ * @handler_ps: fixed overhead of the handler, timed as the sequence it
+ *              runs: timestamp, control register read, ack write, latency
+ *              read, lock and unlock of data_lock. What the enabled
+ *              features add is in the debugfs handler_profile.
+ * @baseline: clock cycles of the reported latencies due to the MMIO of the
+ *            handler, @read_ps + @write_ps
+ * @correct: whether @baseline is subtracted from the latencies stored for
+ *           /dev/irqgen and the per-line channels
+ */
+struct irqgen_calib {
+    u32 runs;
+    u32 read_ps;
+    u32 write_ps;
+    u32 timestamp_ps;
+    u32 lock_ps;
+    u32 handler_ps;
+    u32 baseline;
+    bool correct;
+};
+
+static DEFINE_MUTEX(irqgen_calib_mutex);
+static struct irqgen_calib calib;
+
+// Time CALIB_ITERATIONS runs of `op`, keeping the fastest round, in ps
+#define CALIB_MEASURE(_ps, _op)                                         \
+    do {                                                                \
+        u64 _best = U64_MAX;                                            \
+        int _r, _i;                                                     \
+                                                                        \
+        for (_r = 0; _r < CALIB_ROUNDS; ++_r) {                         \
+            unsigned long _flags;                                       \
+            u64 _t;                                                     \
+                                                                        \
+            local_irq_save(_flags);                                     \
+            _t = ktime_get_ns();                                        \
+            for (_i = 0; _i < CALIB_ITERATIONS; ++_i) {                 \
+                _op;                                                    \
+            }                                                           \
+            _t = ktime_get_ns() - _t;                                   \
+            local_irq_restore(_flags);                                  \
+            _best = min(_best, _t);                                     \
+        }                                                               \
+        _ps = div_u64(_best * 1000, CALIB_ITERATIONS);                  \
+    } while (0)
+
+/*
+ * Measure the costs with the IRQ Generator disabled, from process context.
+ * Fails with -EBUSY while the generator is enabled, as the writes to the
+ * control register would disturb it.
+ */
+int irqgen_calib_run(void)
+{
+    u32 disabled = FIELD_PREP(IRQGEN_CTRL_REG_F_ENABLE, 0);
+    u32 read_ps, write_ps, timestamp_ps, lock_ps, handler_ps;
+    u32 sink = 0;
+    u64 now = 0;
+
+    if (FIELD_GET(IRQGEN_CTRL_REG_F_ENABLE, irqgen_ioread32(IRQGEN_CTRL_REG)))
+        return -EBUSY;
+
+    mutex_lock(&irqgen_calib_mutex);
+
+    CALIB_MEASURE(read_ps, sink += irqgen_ioread32(IRQGEN_LATENCY_REG));
+    // Writes are posted: the read flushing them is part of the last round
+    CALIB_MEASURE(write_ps, irqgen_iowrite32(disabled, IRQGEN_CTRL_REG);
+                            if (_i == CALIB_ITERATIONS - 1) sink += irqgen_ioread32(IRQGEN_CTRL_REG));
+    CALIB_MEASURE(timestamp_ps, now += ktime_get_ns());
+    CALIB_MEASURE(lock_ps, spin_lock(&irqgen_data->data_lock);
+                           spin_unlock(&irqgen_data->data_lock));
+    // The latency read also waits for the posted ack write, as in the handler
+    CALIB_MEASURE(handler_ps, now += ktime_get_ns();
+                              sink += irqgen_ioread32(IRQGEN_CTRL_REG);
+                              irqgen_iowrite32(disabled, IRQGEN_CTRL_REG);
+                              sink += irqgen_ioread32(IRQGEN_LATENCY_REG);
+                              spin_lock(&irqgen_data->data_lock);
+                              spin_unlock(&irqgen_data->data_lock));
+
+    calib.read_ps = read_ps;
+    calib.write_ps = write_ps;
+    calib.timestamp_ps = timestamp_ps;
+    calib.lock_ps = lock_ps;
+    calib.handler_ps = handler_ps;
+    calib.baseline = DIV_ROUND_CLOSEST(read_ps + write_ps, FPGA_CLOCK_NS * 1000);
+    ++calib.runs;
+
+    mutex_unlock(&irqgen_calib_mutex);
+
+    pr_debug(KMSG_PFX "calibration: read %u ps, write %u ps, baseline %u cycles (%u, %llu).\n",
+             read_ps, write_ps, calib.baseline, sink, now);
+    return 0;
+}
+
+// Clock cycles to subtract from the latencies stored by the handler, 0 if
+// the correction is off
+u32 irqgen_calib_baseline(void)
+{
+    return READ_ONCE(calib.correct) ? READ_ONCE(calib.baseline) : 0;
+}
+
+void irqgen_calib_set_correct(bool correct)
+{
+    WRITE_ONCE(calib.correct, correct);
+}
+
+#define PS_FMT "%u.%03u"
+#define PS_ARG(_ps) (_ps) / 1000, (_ps) % 1000
+
+/*
+ * "<read ns> <write ns> <timestamp ns> <lock ns> <handler ns> <baseline
+ * cycles> <correction> <runs>"
+ */
+ssize_t irqgen_calib_show(char *buf)
+{
+    ssize_t len;
+
+    mutex_lock(&irqgen_calib_mutex);
+    len = scnprintf(buf, PAGE_SIZE,
+                    PS_FMT " " PS_FMT " " PS_FMT " " PS_FMT " " PS_FMT " %u %u %u\n",
+                    PS_ARG(calib.read_ps), PS_ARG(calib.write_ps),
+                    PS_ARG(calib.timestamp_ps), PS_ARG(calib.lock_ps),
+                    PS_ARG(calib.handler_ps), calib.baseline,
+                    calib.correct, calib.runs);
+    mutex_unlock(&irqgen_calib_mutex);
+
+    return len;
+}
+
+// The generator is enabled only after probe(): a failure is reported but
+// does not prevent the module from working
+int irqgen_calib_setup(struct platform_device *pdev)
+{
+    int retval = irqgen_calib_run();
+
+    if (0 != retval) {
+        printk(KERN_WARNING KMSG_PFX "Calibration failed with %d.\n", retval);
+        return 0;
+    }
+
+    printk(KERN_INFO KMSG_PFX "MMIO read " PS_FMT " ns, write " PS_FMT " ns, "
+           "handler overhead " PS_FMT " ns, latency baseline %u cycles.\n",
+           PS_ARG(calib.read_ps), PS_ARG(calib.write_ps),
+           PS_ARG(calib.handler_ps), calib.baseline);
+    return 0;
+}
@@ -16,6 +16,8 @@
 # include <linux/cdev.h>             // Header for character devices support
 # include <linux/fs.h>               // Header for Linux file system support
 # include <linux/uaccess.h>          // Header for userspace access support
+# include <linux/poll.h>             // Header for poll support
+# include <linux/ktime.h>            // ktime_get_ns
 #include <linux/spinlock.h>
 # include "irqgen.h"                 // Shared module specific declarations
 
@@ -37,11 +39,17 @@ static struct irqgen_chardev irqgen_chardev;
 static int     irqgen_cdev_open(struct inode *, struct file *);
 static int     irqgen_cdev_release(struct inode *, struct file *);
 static ssize_t irqgen_cdev_read(struct file *, char *, size_t, loff_t *);
+static __poll_t irqgen_cdev_poll(struct file *, poll_table *);
+static long    irqgen_cdev_ioctl(struct file *, unsigned int, unsigned long);
 
 static struct file_operations fops = {
+    .owner = THIS_MODULE,
     .open = irqgen_cdev_open,
     .release = irqgen_cdev_release,
     .read = irqgen_cdev_read,
+    .poll = irqgen_cdev_poll,
+    .unlocked_ioctl = irqgen_cdev_ioctl,
+    .mmap = irqgen_ring_mmap,
 };
 
 // Initialize the char device driver
@@ -85,12 +93,21 @@ int irqgen_cdev_setup(struct platform_device *pdev)
 		goto err_device_create;
 	}
 
+    // One more node per IRQ line, for the per-line channels
+    ret = irqgen_chan_setup(pdev, irqgen_chardev.class);
+    if (ret < 0)
+    {
+        printk(KERN_ERR KMSG_PFX "CHARDEV: Channel setup failed\n");
+        goto err_chan_setup;
+    }
+
     //TODO: do we need a sync mechanism for any cdev operation?
      
     return 0;
 	
 		
     //TODO: use labels to handle errors and undo any resource allocation
+	err_chan_setup:
 	err_device_create:
 		device_destroy(irqgen_chardev.class,irqgen_chardev.devt);
 	err_cdev_add:
@@ -105,6 +122,7 @@ void irqgen_cdev_cleanup(struct platform_device *pdev)
 {
     // destroy, unregister and free, in the right order, all resources
     // allocated in irqgen_cdev_setup()
+    irqgen_chan_cleanup(pdev, irqgen_chardev.class);
     device_destroy (irqgen_chardev.class,irqgen_chardev.devt);
     cdev_del(&irqgen_chardev.cdev);
     unregister_chrdev_region(irqgen_chardev.devt, 1);
@@ -112,29 +130,33 @@ void irqgen_cdev_cleanup(struct platform_device *pdev)
 }
 
 static u8 already_opened = 0;
+// Last batch completion acknowledged by the reader, protected by data_lock
+static u32 done_seen = 0;
 
 static int irqgen_cdev_open(struct inode *inode, struct file *f)
 {
-# ifdef DEBUG
-    printk(KERN_DEBUG KMSG_PFX "irqgen_cdev_open() called.\n");
-# endif
+    pr_debug(KMSG_PFX "irqgen_cdev_open() called.\n");
     if (already_opened) {
         return -EBUSY;
     }
     already_opened = 1;
 
+    spin_lock_irq(&irqgen_data->data_lock);
+    done_seen = irqgen_data->done_seq;
+    spin_unlock_irq(&irqgen_data->data_lock);
+
     return 0;
 }
 
 static int irqgen_cdev_release(struct inode *inode, struct file *f)
 {
-# ifdef DEBUG
-    printk(KERN_DEBUG KMSG_PFX "irqgen_cdev_release() called.\n");
-# endif
+    pr_debug(KMSG_PFX "irqgen_cdev_release() called.\n");
 
     if (!already_opened) {
         return -ECANCELED;
     }
+    irqgen_notify_set_eventfd(-1);
+    irqgen_session_stop(f);
     already_opened = 0;
 
     return 0;
@@ -154,6 +176,9 @@ static ssize_t irqgen_cdev_read(struct file *fp, char *ubuf, size_t count, loff_
     ssize_t ret = 0;
 
     struct latency_data v;
+    struct irqgen_cmd resume;
+    bool issue;
+    u64 now;
 
     if (count < 60) {
         printk(KERN_ERR KMSG_PFX "read() buffer too small (<=60).\n");
@@ -162,7 +187,9 @@ static ssize_t irqgen_cdev_read(struct file *fp, char *ubuf, size_t count, loff_
 
     // TODO: how to protect access to shared r/w members of irqgen_data?
 	spin_lock_irq(&irqgen_data->data_lock);
-	
+    now = ktime_get_ns();
+    irqgen_pipeline_woken(now);
+
     if (irqgen_data->rp == irqgen_data->wp) {
         // Nothing to read
 		spin_unlock_irq(&irqgen_data->data_lock);
@@ -171,8 +198,13 @@ static ssize_t irqgen_cdev_read(struct file *fp, char *ubuf, size_t count, loff_
 
     v = irqgen_data->latencies[irqgen_data->rp];
     irqgen_data->rp = (irqgen_data->rp + 1)%MAX_LATENCIES;
+    irqgen_pipeline_consumed(&v, now);
+    issue = irqgen_flowctl_resume(&resume, false);
 	spin_unlock_irq(&irqgen_data->data_lock);
-    ret = scnprintf(kbuf, KBUF_SIZE, "%u,%lu,%llu\n", v.line, v.latency, v.timestamp);
+
+    if (issue)
+        irqgen_issue(&resume);
+    ret = irqgen_sample_format(kbuf, KBUF_SIZE, &v);
     if (ret < 0) {
         goto end;
     } else if (ret == 0) {
@@ -181,7 +213,10 @@ static ssize_t irqgen_cdev_read(struct file *fp, char *ubuf, size_t count, loff_
     }
 
     // TODO: how to transfer from kernel space to user space?
-    if(copy_to_user(ubuf,kbuf,KBUF_SIZE)!=0) goto end;
+    if (copy_to_user(ubuf, kbuf, ret) != 0) {
+        ret = -EFAULT;
+        goto end;
+    }
     *f_pos += ret;
 
  end:
@@ -189,4 +224,75 @@ static ssize_t irqgen_cdev_read(struct file *fp, char *ubuf, size_t count, loff_
 #undef KBUF_SIZE
 }
 
+// Format a sample as a CSV line for the readers of /dev/irqgen and of the
+// per-line channels
+int irqgen_sample_format(char *buf, size_t size, const struct latency_data *v)
+{
+    return scnprintf(buf, size, "%u,%u,%llu,%u,%u,%u,%u\n",
+                     v->line, v->latency, v->timestamp, latency_data_batch(v),
+                     latency_data_idx(v), v->cpu, v->flags);
+}
+
+// Readable once the latencies buffer holds at least wakeup_threshold
+// samples: the handler wakes the waiting readers at that point.
+// A completed batch not yet acknowledged is reported as priority data.
+static __poll_t irqgen_cdev_poll(struct file *fp, poll_table *wait)
+{
+    __poll_t mask = 0;
+
+    poll_wait(fp, &irqgen_data->readq, wait);
+
+    spin_lock_irq(&irqgen_data->data_lock);
+    if (irqgen_data_pending() >= irqgen_data->wakeup_threshold)
+        mask |= EPOLLIN | EPOLLRDNORM;
+    if (irqgen_data->done_seq != done_seen)
+        mask |= EPOLLPRI;
+    spin_unlock_irq(&irqgen_data->data_lock);
+
+    return mask;
+}
+
+static long irqgen_cdev_ioctl(struct file *fp, unsigned int cmd, unsigned long arg)
+{
+    struct irqgen_batch_info info = {0};
+    struct irqgen_session_req req;
+    s32 fd;
+
+    switch (cmd) {
+    case IRQGEN_IOC_SET_EVENTFD:
+        if (get_user(fd, (s32 __user *)arg))
+            return -EFAULT;
+        return irqgen_notify_set_eventfd(fd);
+
+    case IRQGEN_IOC_GET_DONE:
+        spin_lock_irq(&irqgen_data->data_lock);
+        info.id = irqgen_data->last_done.id;
+        info.line = irqgen_data->last_done.line;
+        info.amount = irqgen_data->last_done.amount;
+        info.handled = irqgen_data->last_done.handled;
+        info.issued_ns = irqgen_data->last_done.issued_ns;
+        info.done_ns = irqgen_data->last_done.done_ns;
+        done_seen = irqgen_data->done_seq;
+        spin_unlock_irq(&irqgen_data->data_lock);
 
+        if (copy_to_user((void __user *)arg, &info, sizeof(info)))
+            return -EFAULT;
+        return 0;
+
+    case IRQGEN_IOC_RING_ENTER:
+        return irqgen_ring_enter();
+
+    case IRQGEN_IOC_SESSION:
+        if (copy_from_user(&req, (void __user *)arg, sizeof(req)))
+            return -EFAULT;
+        if (!(req.flags & IRQGEN_SESSION_START)) {
+            irqgen_session_stop(fp);
+            return 0;
+        }
+        return irqgen_session_start(req.latency_us,
+                                    req.flags & IRQGEN_SESSION_PIN_FREQ, fp);
+
+    default:
+        return -ENOTTY;
+    }
+}
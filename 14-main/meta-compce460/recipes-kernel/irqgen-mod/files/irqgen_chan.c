@@ -0,0 +1,513 @@
+/**
+ * @file   irqgen_chan.c
+ * @date   17 October 2026
+ * @target_device Xilinx PYNQ-Z1
+ * @brief   Per-line sample channels of irqgen.ko, read through
+ *          /dev/irqgen-line<N> as CSV lines or binary records.
+ */
+
+# include <linux/kernel.h>           // Contains types, macros, functions for the kernel
+# include <linux/module.h>           // module_param
+# include <linux/device.h>
+# include <linux/cdev.h>             // Header for character devices support
+# include <linux/fs.h>               // Header for Linux file system support
+# include <linux/uaccess.h>          // Header for userspace access support
+# include <linux/poll.h>             // Header for poll support
+# include <linux/mutex.h>
+# include <linux/slab.h>             // kvcalloc/kvfree
+# include <linux/string.h>
+
+# include "irqgen.h"                 // Shared module specific declarations
+
+# define CHAN_MAX_SIZE (1 << 20)     // Largest ring of a channel, in samples
+
+static unsigned int chan_size = 1024;
+module_param(chan_size, uint, 0444);
+MODULE_PARM_DESC(chan_size, "Initial ring size in samples of each per-line channel (0 disables them).");
+
+/*
+ * The nodes /dev/irqgen-line<N>, one minor per IRQ line.
+ * Resizing a channel and opening its node are serialized by chan_mutex,
+ * its ring positions are protected by irqgen_data->data_lock.
+ */
+static struct cdev chan_cdev;
+static dev_t chan_devt;
+static DEFINE_MUTEX(chan_mutex);
+
+// Source of each field of the records, in IRQGEN_FIELD_* order. The fields
+// of a feature left out of the build have a size of 0: they are not stored.
+static const struct irqgen_chan_field chan_fields[IRQGEN_FIELD_COUNT] = {
+    [IRQGEN_FIELD_TIMESTAMP] = { offsetof(struct latency_data, timestamp), 0, 8 },
+    [IRQGEN_FIELD_LATENCY]   = { offsetof(struct latency_data, latency), 0, 4 },
+#ifdef IRQGEN_CONFIG_STATS
+    [IRQGEN_FIELD_PUBLISH]   = { offsetof(struct latency_data, publish_ns), 0, 4 },
+#endif
+#ifdef IRQGEN_CONFIG_BATCHES
+    [IRQGEN_FIELD_BATCH]     = { offsetof(struct latency_data, batch), 0, 4 },
+    [IRQGEN_FIELD_IDX]       = { offsetof(struct latency_data, idx), 0, 4 },
+#endif
+    [IRQGEN_FIELD_SEQ]       = { IRQGEN_CHAN_SRC_SEQ, 0, 4 },
+    [IRQGEN_FIELD_LINE]      = { offsetof(struct latency_data, line), 0, 1 },
+    [IRQGEN_FIELD_CPU]       = { offsetof(struct latency_data, cpu), 0, 1 },
+    [IRQGEN_FIELD_FLAGS]     = { offsetof(struct latency_data, flags), 0, 1 },
+};
+
+// Mask of the fields this build can store
+static u32 chan_fields_avail(void)
+{
+    u32 fields = 0;
+    int f;
+
+    for (f = 0; f < IRQGEN_FIELD_COUNT; ++f)
+        if (0 != chan_fields[f].size)
+            fields |= 1U << f;
+
+    return fields;
+}
+
+/*
+ * Lay out the records of `fields`: the fields come in decreasing size, so
+ * that each one is at its natural alignment.
+ * Returns the stride of the records.
+ */
+static u16 chan_layout(u32 fields, struct irqgen_chan_field *layout, u8 *nfields)
+{
+    u16 off = 0;
+    u8 align = 1;
+    int f, n = 0;
+
+    for (f = 0; f < IRQGEN_FIELD_COUNT; ++f) {
+        if (!(fields & (1U << f)))
+            continue;
+        layout[n] = chan_fields[f];
+        layout[n].dst = off;
+        off += layout[n].size;
+        align = max(align, layout[n].size);
+        ++n;
+    }
+    *nfields = n;
+
+    return ALIGN(off, align);
+}
+
+// Copy a field between aligned locations
+static inline void chan_copy(void *dst, const void *src, u8 size)
+{
+    switch (size) {
+    case 8: *(u64 *)dst = *(const u64 *)src; break;
+    case 4: *(u32 *)dst = *(const u32 *)src; break;
+    default: *(u8 *)dst = *(const u8 *)src; break;
+    }
+}
+
+// Slow path of irqgen_chan_push(), for enabled channels
+bool __irqgen_chan_push(struct irqgen_chan *c, const struct latency_data *s)
+{
+    u8 *rec = c->ring + (size_t)c->wp * c->stride;
+    int i;
+
+    for (i = 0; i < c->nfields; ++i) {
+        const struct irqgen_chan_field *l = &c->layout[i];
+
+        if (IRQGEN_CHAN_SRC_SEQ == l->src)
+            chan_copy(rec + l->dst, &c->seq, l->size);
+        else
+            chan_copy(rec + l->dst, (const u8 *)s + l->src, l->size);
+    }
+    ++c->seq;
+
+    c->wp = (c->wp + 1) % c->size;
+    if (c->wp == c->rp) {
+        ++c->dropped;
+        c->rp = (c->rp + 1) % c->size;
+    }
+
+    return wq_has_sleeper(&c->readq);
+}
+
+// Number of unread samples in a channel
+static inline u32 chan_pending(const struct irqgen_chan *c)
+{
+    return 0 == c->size ? 0 : (c->wp - c->rp + c->size) % c->size;
+}
+
+// Rebuild a sample from a record, the fields not in the record are 0
+static void chan_unpack(const struct irqgen_chan *c, const u8 *rec, struct latency_data *v)
+{
+    int i;
+
+    memset(v, 0, sizeof(*v));
+    for (i = 0; i < c->nfields; ++i) {
+        const struct irqgen_chan_field *l = &c->layout[i];
+
+        if (IRQGEN_CHAN_SRC_SEQ != l->src)
+            chan_copy((u8 *)v + l->src, rec + l->dst, l->size);
+    }
+}
+
+// Most unread samples in an open channel, for the flow control: runs with
+// the data_lock held
+u32 irqgen_chan_backlog(void)
+{
+    u32 n = 0;
+    int i;
+
+    for (i = 0; i < irqgen_data->line_count; ++i) {
+        const struct irqgen_chan *c = &irqgen_data->chans[i];
+
+        if (READ_ONCE(c->opened))
+            n = max(n, chan_pending(c));
+    }
+
+    return n;
+}
+
+/*
+ * Replace the ring of a channel with an empty one of `size` records of
+ * `fields` (0 to keep the current ones), or disable the channel with a
+ * size of 0. Fails with -EBUSY while its node is open, and with
+ * -EOPNOTSUPP for a field of a feature left out of the build.
+ */
+int irqgen_chan_resize(int line, u32 size, u32 fields)
+{
+    struct irqgen_chan *c;
+    struct irqgen_chan_field layout[IRQGEN_FIELD_COUNT];
+    u8 *ring = NULL, *old;
+    u8 nfields;
+    u16 stride;
+
+    if (line < 0 || line >= irqgen_data->line_count || size > CHAN_MAX_SIZE)
+        return -ERANGE;
+    // One slot stays free to tell a full ring from an empty one
+    if (1 == size || (fields & ~IRQGEN_FIELDS_ALL))
+        return -EINVAL;
+    if (fields & ~chan_fields_avail())
+        return -EOPNOTSUPP;
+    c = &irqgen_data->chans[line];
+
+    mutex_lock(&chan_mutex);
+    if (c->opened) {
+        mutex_unlock(&chan_mutex);
+        return -EBUSY;
+    }
+    if (0 == fields)
+        fields = c->fields ? c->fields : IRQGEN_FIELDS_DEFAULT & chan_fields_avail();
+    stride = chan_layout(fields, layout, &nfields);
+
+    if (0 != size) {
+        ring = kvcalloc(size, stride, GFP_KERNEL);
+        if (!ring) {
+            mutex_unlock(&chan_mutex);
+            return -ENOMEM;
+        }
+    }
+
+    spin_lock_irq(&irqgen_data->data_lock);
+    old = c->ring;
+    c->ring = ring;
+    c->size = size;
+    c->wp = c->rp = 0;
+    c->dropped = 0;
+    c->seq = 0;
+    c->fields = fields;
+    c->stride = stride;
+    c->nfields = nfields;
+    memcpy(c->layout, layout, sizeof(layout));
+    spin_unlock_irq(&irqgen_data->data_lock);
+    mutex_unlock(&chan_mutex);
+
+    kvfree(old);
+    return 0;
+}
+
+// "<line> <size> <pending> <dropped> <fields> <stride>" for each line
+ssize_t irqgen_chan_show(char *buf)
+{
+    ssize_t len = 0;
+    int i;
+
+    for (i = 0; i < irqgen_data->line_count; ++i) {
+        struct irqgen_chan *c = &irqgen_data->chans[i];
+        u32 size, pending, dropped, fields;
+        u16 stride;
+
+        spin_lock_irq(&irqgen_data->data_lock);
+        size = c->size;
+        pending = chan_pending(c);
+        dropped = c->dropped;
+        fields = c->fields;
+        stride = c->stride;
+        spin_unlock_irq(&irqgen_data->data_lock);
+
+        len += scnprintf(buf + len, PAGE_SIZE - len, "%d %u %u %u 0x%x %u\n",
+                         i, size, pending, dropped, fields, stride);
+    }
+
+    return len;
+}
+
+static int irqgen_chan_open(struct inode *inode, struct file *f)
+{
+    int line = iminor(inode) - MINOR(chan_devt);
+    struct irqgen_chan *c = &irqgen_data->chans[line];
+    int retval = 0;
+
+    mutex_lock(&chan_mutex);
+    if (0 == c->size) {
+        retval = -ENODEV;
+    } else if (c->opened) {
+        retval = -EBUSY;
+    } else {
+        c->opened = true;
+        c->binary = false;
+        c->hdr_sent = false;
+    }
+    mutex_unlock(&chan_mutex);
+
+    f->private_data = c;
+    return retval;
+}
+
+static int irqgen_chan_release(struct inode *inode, struct file *f)
+{
+    struct irqgen_chan *c = f->private_data;
+    struct irqgen_cmd resume;
+    bool issue;
+
+    mutex_lock(&chan_mutex);
+    c->opened = false;
+    mutex_unlock(&chan_mutex);
+
+    // The backlog of a channel without reader no longer holds a pause
+    spin_lock_irq(&irqgen_data->data_lock);
+    issue = irqgen_flowctl_resume(&resume, false);
+    spin_unlock_irq(&irqgen_data->data_lock);
+    if (issue)
+        irqgen_issue(&resume);
+
+    return 0;
+}
+
+// The schema header of the binary records of a channel
+static void chan_schema(const struct irqgen_chan *c, struct irqgen_schema *h)
+{
+    int f, i = 0;
+
+    memset(h, 0, sizeof(*h));
+    h->magic = IRQGEN_SCHEMA_MAGIC;
+    h->version = IRQGEN_SCHEMA_VERSION;
+    h->stride = c->stride;
+    h->fields = c->fields;
+    for (f = 0; f < IRQGEN_FIELD_COUNT; ++f) {
+        if (!(c->fields & (1U << f)))
+            continue;
+        h->layout[f].offset = c->layout[i].dst;
+        h->layout[f].size = c->layout[i].size;
+        ++i;
+    }
+}
+
+/*
+ * Binary read: the schema header first, then as many whole records as fit
+ * in the user buffer, bounced through a page as the ring is only stable
+ * under data_lock
+ */
+static ssize_t chan_read_binary(struct irqgen_chan *c, char __user *ubuf, size_t count)
+{
+    struct irqgen_schema h;
+    struct irqgen_cmd resume;
+    bool issue;
+    u8 *kbuf;
+    u32 n, i;
+    ssize_t ret;
+
+    if (!c->hdr_sent) {
+        if (count < sizeof(h))
+            return -ENOBUFS;
+        chan_schema(c, &h);
+        if (copy_to_user(ubuf, &h, sizeof(h)) != 0)
+            return -EFAULT;
+        c->hdr_sent = true;
+        return sizeof(h);
+    }
+
+    n = min_t(size_t, count, PAGE_SIZE) / c->stride;
+    if (0 == n)
+        return -ENOBUFS;
+    kbuf = kmalloc(PAGE_SIZE, GFP_KERNEL);
+    if (!kbuf)
+        return -ENOMEM;
+
+    spin_lock_irq(&irqgen_data->data_lock);
+    n = min(n, chan_pending(c));
+    for (i = 0; i < n; ++i) {
+        memcpy(kbuf + i * c->stride, c->ring + (size_t)c->rp * c->stride, c->stride);
+        c->rp = (c->rp + 1) % c->size;
+    }
+    issue = irqgen_flowctl_resume(&resume, false);
+    spin_unlock_irq(&irqgen_data->data_lock);
+
+    if (issue)
+        irqgen_issue(&resume);
+
+    ret = n * c->stride;
+    if (copy_to_user(ubuf, kbuf, ret) != 0)
+        ret = -EFAULT;
+    kfree(kbuf);
+
+    return ret;
+}
+
+// One CSV line per read, in the format of /dev/irqgen, or binary records
+// after IRQGEN_IOC_CHAN_BINARY
+static ssize_t irqgen_chan_read(struct file *f, char __user *ubuf, size_t count, loff_t *f_pos)
+{
+#define KBUF_SIZE 100
+    struct irqgen_chan *c = f->private_data;
+    char kbuf[KBUF_SIZE];
+    struct latency_data v;
+    struct irqgen_cmd resume;
+    bool issue;
+    ssize_t ret;
+
+    if (c->binary) {
+        ret = chan_read_binary(c, ubuf, count);
+        if (ret > 0)
+            *f_pos += ret;
+        return ret;
+    }
+
+    if (count < 60)
+        return -ENOBUFS;
+
+    spin_lock_irq(&irqgen_data->data_lock);
+    if (c->rp == c->wp) {
+        // Nothing to read
+        spin_unlock_irq(&irqgen_data->data_lock);
+        return 0;
+    }
+    chan_unpack(c, c->ring + (size_t)c->rp * c->stride, &v);
+    c->rp = (c->rp + 1) % c->size;
+    issue = irqgen_flowctl_resume(&resume, false);
+    spin_unlock_irq(&irqgen_data->data_lock);
+
+    if (issue)
+        irqgen_issue(&resume);
+
+    ret = irqgen_sample_format(kbuf, KBUF_SIZE, &v);
+    if (copy_to_user(ubuf, kbuf, ret) != 0)
+        return -EFAULT;
+    *f_pos += ret;
+
+    return ret;
+#undef KBUF_SIZE
+}
+
+static long irqgen_chan_ioctl(struct file *f, unsigned int cmd, unsigned long arg)
+{
+    struct irqgen_chan *c = f->private_data;
+
+    switch (cmd) {
+    case IRQGEN_IOC_CHAN_BINARY:
+        c->binary = true;
+        return 0;
+
+    default:
+        return -ENOTTY;
+    }
+}
+
+// Readable as soon as the channel holds a sample
+static __poll_t irqgen_chan_poll(struct file *f, poll_table *wait)
+{
+    struct irqgen_chan *c = f->private_data;
+    __poll_t mask = 0;
+
+    poll_wait(f, &c->readq, wait);
+
+    spin_lock_irq(&irqgen_data->data_lock);
+    if (c->rp != c->wp)
+        mask |= EPOLLIN | EPOLLRDNORM;
+    spin_unlock_irq(&irqgen_data->data_lock);
+
+    return mask;
+}
+
+static const struct file_operations chan_fops = {
+    .owner = THIS_MODULE,
+    .open = irqgen_chan_open,
+    .release = irqgen_chan_release,
+    .read = irqgen_chan_read,
+    .poll = irqgen_chan_poll,
+    .unlocked_ioctl = irqgen_chan_ioctl,
+};
+
+/*
+ * Allocate the rings of chan_size samples and create the nodes on the
+ * class of /dev/irqgen: a "line<N>" directory under /dev/irqgen is not
+ * possible since that path is already the node of the merged view
+ */
+int irqgen_chan_setup(struct platform_device *pdev, struct class *class)
+{
+    int line_count = irqgen_data->line_count;
+    int retval, i;
+
+    for (i = 0; i < line_count; ++i)
+        init_waitqueue_head(&irqgen_data->chans[i].readq);
+
+    if (chan_size > CHAN_MAX_SIZE || 1 == chan_size) {
+        printk(KERN_WARNING KMSG_PFX "chan_size parameter out of range: channels disabled.\n");
+        chan_size = 0;
+    }
+    for (i = 0; i < line_count && 0 != chan_size; ++i) {
+        retval = irqgen_chan_resize(i, chan_size, 0);
+        if (0 != retval)
+            goto err_resize;
+    }
+
+    retval = alloc_chrdev_region(&chan_devt, 0, line_count, DRIVER_NAME "-line");
+    if (retval < 0)
+        goto err_resize;
+
+    cdev_init(&chan_cdev, &chan_fops);
+    chan_cdev.owner = THIS_MODULE;
+    retval = cdev_add(&chan_cdev, chan_devt, line_count);
+    if (retval < 0)
+        goto err_cdev_add;
+
+    for (i = 0; i < line_count; ++i) {
+        struct device *dev = device_create(class, &pdev->dev, chan_devt + i, NULL,
+                                           DRIVER_NAME "-line%d", i);
+
+        if (IS_ERR(dev)) {
+            retval = PTR_ERR(dev);
+            goto err_device_create;
+        }
+    }
+
+    return 0;
+
+ err_device_create:
+    while (i-- > 0)
+        device_destroy(class, chan_devt + i);
+    cdev_del(&chan_cdev);
+ err_cdev_add:
+    unregister_chrdev_region(chan_devt, line_count);
+ err_resize:
+    for (i = 0; i < line_count; ++i)
+        irqgen_chan_resize(i, 0, 0);
+    return retval;
+}
+
+void irqgen_chan_cleanup(struct platform_device *pdev, struct class *class)
+{
+    int line_count = irqgen_data->line_count;
+    int i;
+
+    for (i = 0; i < line_count; ++i)
+        device_destroy(class, chan_devt + i);
+    cdev_del(&chan_cdev);
+    unregister_chrdev_region(chan_devt, line_count);
+    for (i = 0; i < line_count; ++i)
+        irqgen_chan_resize(i, 0, 0);
+}
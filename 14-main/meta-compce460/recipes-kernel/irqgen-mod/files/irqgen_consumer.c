@@ -0,0 +1,132 @@
+/**
+ * @file   irqgen_consumer.c
+ * @date   17 October 2026
+ * @target_device Xilinx PYNQ-Z1
+ * @brief   In-kernel consumer API of irqgen.ko: delivers the latency of
+ *          each handled IRQ to the callbacks of other modules.
+ */
+
+# include <linux/kernel.h>           // Contains types, macros, functions for the kernel
+# include <linux/module.h>           // EXPORT_SYMBOL_GPL
+# include <linux/mutex.h>
+# include <linux/rculist.h>          // RCU-protected list of consumers
+# include <linux/slab.h>             // Kernel slab allocator
+# include <linux/log2.h>             // is_power_of_2
+
+# include "irqgen.h"                 // Shared module specific declarations
+# include "irqgen_consumer.h"        // Public consumer API
+
+DEFINE_STATIC_KEY_FALSE(irqgen_consumer_key);
+
+// Readers are the handlers, writers are serialized by consumers_mutex
+static LIST_HEAD(consumers);
+static DEFINE_MUTEX(consumers_mutex);
+static int consumers_count = 0;
+
+// Called by the handler with the event of a handled IRQ: hard IRQ
+// handlers are RCU read-side critical sections
+void __irqgen_consumers_dispatch(const struct irqgen_event *e)
+{
+    struct irqgen_consumer *c;
+
+    rcu_read_lock();
+    list_for_each_entry_rcu(c, &consumers, node) {
+        u32 tail;
+
+        if (0 != c->line_mask && !(c->line_mask & BIT(e->line)))
+            continue;
+
+        if (NULL != c->event) {
+            c->event(c, e);
+            continue;
+        }
+
+        // The handlers of different lines may run concurrently: the
+        // producers are serialized, the reader is lockless
+        spin_lock(&c->lock);
+        tail = c->tail;
+        if (tail - smp_load_acquire(&c->head) >= c->ring_size) {
+            ++c->overruns;
+            spin_unlock(&c->lock);
+            continue;
+        }
+        c->ring[tail & (c->ring_size - 1)] = *e;
+        smp_store_release(&c->tail, tail + 1);
+        spin_unlock(&c->lock);
+
+        if (wq_has_sleeper(&c->wait))
+            wake_up_interruptible(&c->wait);
+    }
+    rcu_read_unlock();
+}
+
+int irqgen_consumer_register(struct irqgen_consumer *c)
+{
+    if (NULL == c->event && NULL == c->ring)
+        return -EINVAL;
+
+    mutex_lock(&consumers_mutex);
+    if (consumers_count >= IRQGEN_MAX_CONSUMERS) {
+        mutex_unlock(&consumers_mutex);
+        return -EBUSY;
+    }
+    ++consumers_count;
+    list_add_tail_rcu(&c->node, &consumers);
+    static_branch_enable(&irqgen_consumer_key);
+    mutex_unlock(&consumers_mutex);
+
+    return 0;
+}
+EXPORT_SYMBOL_GPL(irqgen_consumer_register);
+
+void irqgen_consumer_unregister(struct irqgen_consumer *c)
+{
+    mutex_lock(&consumers_mutex);
+    list_del_rcu(&c->node);
+    if (0 == --consumers_count)
+        static_branch_disable(&irqgen_consumer_key);
+    mutex_unlock(&consumers_mutex);
+
+    // Wait for the handlers which may still see `c`
+    synchronize_rcu();
+}
+EXPORT_SYMBOL_GPL(irqgen_consumer_unregister);
+
+int irqgen_consumer_ring_init(struct irqgen_consumer *c, u32 size)
+{
+    if (!is_power_of_2(size))
+        return -EINVAL;
+
+    c->ring = kcalloc(size, sizeof(*c->ring), GFP_KERNEL);
+    if (NULL == c->ring)
+        return -ENOMEM;
+    c->ring_size = size;
+    c->head = 0;
+    c->tail = 0;
+    c->overruns = 0;
+    spin_lock_init(&c->lock);
+    init_waitqueue_head(&c->wait);
+
+    return 0;
+}
+EXPORT_SYMBOL_GPL(irqgen_consumer_ring_init);
+
+void irqgen_consumer_ring_free(struct irqgen_consumer *c)
+{
+    kfree(c->ring);
+    c->ring = NULL;
+}
+EXPORT_SYMBOL_GPL(irqgen_consumer_ring_free);
+
+bool irqgen_consumer_pop(struct irqgen_consumer *c, struct irqgen_event *e)
+{
+    u32 head = c->head;
+
+    if (smp_load_acquire(&c->tail) == head)
+        return false;
+
+    *e = c->ring[head & (c->ring_size - 1)];
+    smp_store_release(&c->head, head + 1);
+    return true;
+}
+EXPORT_SYMBOL_GPL(irqgen_consumer_pop);
@@ -0,0 +1,111 @@
+/**
+ * @file   irqgen_consumer.h
+ * @date   17 October 2026
+ * @target_device Xilinx PYNQ-Z1
+ * @brief   In-kernel consumer API of the IRQ Generator module: other modules
+ *          include this header to receive the latency of each handled IRQ.
+ */
+
+#ifndef __IRQGEN_CONSUMER_H
+#define __IRQGEN_CONSUMER_H
+
+# include <linux/types.h>
+# include <linux/list.h>
+# include <linux/spinlock.h>
+# include <linux/wait.h>
+
+# define IRQGEN_MAX_CONSUMERS 8     // Bounds the dispatch cost in the handler
+
+/*-
+ * A handled IRQ, as delivered to the consumers
+ *
+ * @timestamp: timestamp in ns when the handler was started for the IRQ
+ * @latency: number of clock cycles reported by the FPGA module between
+ *           IRQ issue and acknowledgment
+ * @line: which interrupt line generated the IRQ
+ * @cpu: the CPU which handled the IRQ
+ * @batch: ID of the generation command which issued the IRQ (0 if unknown)
+ * @idx: index of the IRQ within its batch
+ * @flags: IRQGEN_SAMPLE_* flags
+ */
+struct irqgen_event {
+    u64 timestamp;
+    u32 latency;
+    u8  line;
+    u8  cpu;
+    u32 batch;
+    u32 idx;
+    u8  flags;
+};
+
+/*-
+ * A consumer of the latency events
+ *
+ * Events are delivered for every handled IRQ of the lines in @line_mask,
+ * regardless of the sample filter of the latency buffer, either to @event
+ * or, if it is NULL, to the ring set up with irqgen_consumer_ring_init().
+ *
+ * @event: called in hard IRQ context, after the handler released its lock:
+ *         it must not sleep and should return quickly, and it may run
+ *         concurrently for IRQs of different lines
+ * @line_mask: bit i set to receive the events of line i, 0 for all lines
+ * @ring: the events, when @event is NULL: filled by the handler, emptied by
+ *        irqgen_consumer_pop()
+ * @ring_size: number of entries of @ring, a power of 2
+ * @head: next entry to pop, written by the consumer
+ * @tail: next entry to fill, written by the handler
+ * @overruns: events lost because the ring was full
+ * @wait: woken up by the handler after filling the ring
+ * @lock: private to the IRQ Generator module, serializes the handlers
+ *        filling the ring
+ * @node: private to the IRQ Generator module
+ */
+struct irqgen_consumer {
+    void (*event)(struct irqgen_consumer *c, const struct irqgen_event *e);
+    u32 line_mask;
+
+    struct irqgen_event *ring;
+    u32 ring_size;
+    u32 head;
+    u32 tail;
+    u32 overruns;
+    wait_queue_head_t wait;
+
+    spinlock_t lock;
+    struct list_head node;
+};
+
+/*
+ * Start delivering events to `c`, which must stay valid until
+ * irqgen_consumer_unregister(). Returns 0, or -EBUSY if
+ * IRQGEN_MAX_CONSUMERS are already registered. May sleep.
+ */
+int irqgen_consumer_register(struct irqgen_consumer *c);
+
+/*
+ * Stop delivering events to `c`: when it returns, no callback is running
+ * and the handler does not touch `c` anymore. May sleep.
+ */
+void irqgen_consumer_unregister(struct irqgen_consumer *c);
+
+/*
+ * Allocate a ring of `size` entries (a power of 2) for a consumer without
+ * callback, before registering it. Returns 0 or -errno.
+ */
+int irqgen_consumer_ring_init(struct irqgen_consumer *c, u32 size);
+// Free the ring, after unregistering the consumer
+void irqgen_consumer_ring_free(struct irqgen_consumer *c);
+
+/*
+ * Pop the oldest event of the ring of `c` into `e`, from a single reader.
+ * Returns whether there was one. Sleep until there is with
+ * wait_event_interruptible(c->wait, irqgen_consumer_pending(c)).
+ */
+bool irqgen_consumer_pop(struct irqgen_consumer *c, struct irqgen_event *e);
+
+static inline bool irqgen_consumer_pending(const struct irqgen_consumer *c)
+{
+    return READ_ONCE(c->tail) != READ_ONCE(c->head);
+}
+
+#endif /* !defined(__IRQGEN_CONSUMER_H) */
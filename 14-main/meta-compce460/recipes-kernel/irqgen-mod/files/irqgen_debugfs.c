@@ -0,0 +1,83 @@
+/**
+ * @file   irqgen_debugfs.c
+ * @date   17 October 2026
+ * @target_device Xilinx PYNQ-Z1
+ * @brief   debugfs files of irqgen.ko, under /sys/kernel/debug/irqgen.
+ */
+
+# include <linux/kernel.h>           // Contains types, macros, functions for the kernel
+# include <linux/debugfs.h>          // Header for debugfs support
+# include <linux/vmalloc.h>          // vzalloc/vfree
+# include <linux/seq_file.h>         // Sequential files for debugfs output
+# include <linux/math64.h>           // 64-bit divisions
+
+# include "irqgen.h"                 // Shared module specific declarations
+
+static struct dentry *irqgen_debugfs_dir = NULL;
+
+// Allocate a zeroed snapshot with room for `size` bytes of data
+struct irqgen_snapshot *irqgen_snapshot_alloc(size_t size)
+{
+    struct irqgen_snapshot *snap = vzalloc(sizeof(*snap) + size);
+
+    if (NULL != snap)
+        snap->size = size;
+    return snap;
+}
+
+// read() and release() for files whose open() stores a snapshot in
+// private_data
+ssize_t irqgen_snapshot_read(struct file *f, char __user *ubuf, size_t count, loff_t *ppos)
+{
+    struct irqgen_snapshot *snap = f->private_data;
+
+    return simple_read_from_buffer(ubuf, count, ppos, snap->data, snap->size);
+}
+
+int irqgen_snapshot_release(struct inode *inode, struct file *f)
+{
+    vfree(f->private_data);
+    return 0;
+}
+
+// Print a histogram as "<name> <count> <mean> <max>" followed by its bins
+void irqgen_hist_show(struct seq_file *m, const char *name, const struct irqgen_hist *h)
+{
+    int i;
+
+    seq_printf(m, "%s %llu %llu %llu", name, h->count,
+               h->count ? div64_u64(h->sum, h->count) : 0, h->max);
+    for (i = 0; i < IRQGEN_HIST_BINS; ++i)
+        seq_printf(m, " %u", h->bins[i]);
+    seq_putc(m, '\n');
+}
+
+// Debugfs is a debugging aid: failing to set it up is reported but does not
+// prevent the module from working
+int irqgen_debugfs_setup(struct platform_device *pdev)
+{
+    irqgen_debugfs_dir = debugfs_create_dir(DRIVER_NAME, NULL);
+    if (IS_ERR_OR_NULL(irqgen_debugfs_dir)) {
+        printk(KERN_WARNING KMSG_PFX "debugfs_create_dir() failed.\n");
+        irqgen_debugfs_dir = NULL;
+        return 0;
+    }
+
+#ifdef IRQGEN_CONFIG_STATS
+    debugfs_create_file("rollups", 0444, irqgen_debugfs_dir, NULL, &irqgen_rollup_fops);
+    debugfs_create_file("handler_profile", 0644, irqgen_debugfs_dir, NULL, &irqgen_hprof_fops);
+    debugfs_create_file("pmu", 0444, irqgen_debugfs_dir, NULL, &irqgen_pmu_fops);
+#endif
+#ifdef IRQGEN_CONFIG_SAMPLES
+    debugfs_create_file("capture", 0444, irqgen_debugfs_dir, NULL, &irqgen_capture_fops);
+    debugfs_create_file("pipeline", 0644, irqgen_debugfs_dir, NULL, &irqgen_pipeline_fops);
+#endif
+
+    return 0;
+}
+
+void irqgen_debugfs_cleanup(struct platform_device *pdev)
+{
+    debugfs_remove_recursive(irqgen_debugfs_dir);
+    irqgen_debugfs_dir = NULL;
+}
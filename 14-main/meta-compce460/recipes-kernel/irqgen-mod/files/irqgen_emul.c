@@ -0,0 +1,361 @@
+/**
+ * @file   irqgen_emul.c
+ * @date   17 October 2026
+ * @target_device any Linux machine
+ * @brief   Software emulation of the IRQ Generator IP block, to run
+ *          irqgen.ko on a machine without the FPGA.
+ *
+ * Registers an "irqgen" platform device whose IRQ lines come from the
+ * interrupt simulator (CONFIG_IRQ_SIM), and emulates the registers of the
+ * IRQ Generator for an irqgen.ko built with IRQGEN_EMUL=y, which accesses
+ * them through irqgen_emul_read() and irqgen_emul_write(). Load this module
+ * first: the platform device has to exist when irqgen.ko probes.
+ *
+ * The emulated device follows the model of the FPGA: the IRQ k of a
+ * command is due at k * delay FPGA cycles after the command, but is only
+ * raised once the previous IRQ of its line was acknowledged, and its
+ * latency is counted from when it was due.
+ *
+ * With vtime=1 the latencies are counted on a virtual clock instead,
+ * advanced by vtime_service_ns at each ack, and the next IRQ is raised right
+ * after the ack: the samples no longer depend on the load of the machine.
+ */
+
+#include <linux/init.h>             // Macros used to mark up functions e.g., __init __ex
+#include <linux/module.h>           // Core header for loading LKMs into the kern
+#include <linux/kernel.h>           // Contains types, macros, functions for the kernel
+#include <linux/platform_device.h>  // Platform device related functions
+#include <linux/property.h>         // Software node properties
+#include <linux/interrupt.h>        // Interrupt handling functions
+#include <linux/irq.h>              // irq_set_irqchip_state
+#include <linux/irq_sim.h>          // Interrupt simulator
+#include <linux/irqdomain.h>
+#include <linux/hrtimer.h>
+#include <linux/spinlock.h>
+#include <linux/ktime.h>            // ktime_get_ns
+
+#define IRQGEN_CONFIG_EMUL
+#include "irqgen_addresses.h"       // Device specific addresses
+
+#define DRIVER_NAME "irqgen"        // Bound by irqgen.ko
+#define KMSG_PFX "IRQGEN-EMUL: "
+
+#define FPGA_CLOCK_NS   10 /* 1000 / FPGA_CLOCK_MHZ */
+#define EMUL_MAX_LINES  16          // 4 bits of the GENIRQ line field
+
+/* vvvv ---- LKM Parameters vvvv ---- */
+static unsigned int lines = 4;
+module_param(lines, uint, 0444);
+MODULE_PARM_DESC(lines, "Number of emulated IRQ lines.");
+
+static bool vtime = false;
+module_param(vtime, bool, 0444);
+MODULE_PARM_DESC(vtime, "Count the latencies on a virtual clock, for deterministic samples.");
+
+static unsigned int vtime_service_ns = 1000;
+module_param(vtime_service_ns, uint, 0444);
+MODULE_PARM_DESC(vtime_service_ns, "Virtual time in ns from an IRQ being raised to its ack, with vtime=1.");
+/* ^^^^ ---- LKM Parameters ^^^^ ---- */
+
+/*-
+ * State of an emulated IRQ line
+ *
+ * @virq: the Linux IRQ number mapped from the interrupt simulator
+ * @timer: raises the next IRQ when it is due, in real time
+ * @amount: IRQs of the current command
+ * @next: index in the command of the next IRQ to raise
+ * @delay_ns: delay between the IRQs of the command
+ * @start_ns: time in ns when the command was written (virtual with vtime)
+ * @due_ns: time in ns when the IRQ in flight was due
+ * @in_flight: whether an IRQ is raised and not acknowledged yet
+ */
+struct emul_line {
+    unsigned int virq;
+    struct hrtimer timer;
+    u32 amount;
+    u32 next;
+    u64 delay_ns;
+    u64 start_ns;
+    u64 due_ns;
+    bool in_flight;
+};
+
+/*-
+ * The emulated IRQ Generator
+ *
+ * @regs: the register block handed out as register base, only used to
+ *        decode the register offsets
+ * @acks: the ack value of each line, as in the "wapice,intrack" property
+ * @lock: serializes the register accesses and the timers
+ * @enabled: IRQGEN_CTRL_REG_F_ENABLE
+ * @count: IRQs raised since load, IRQGEN_IRQ_COUNT_REG
+ * @latency: latency in cycles of the last acknowledged IRQ
+ * @vnow: the virtual clock in ns, with vtime
+ * @lines: the IRQ lines
+ */
+struct irqgen_emul {
+    u32 regs[IRQGEN_LATENCY_REG_OFFSET / sizeof(u32) + 1];
+    u32 acks[EMUL_MAX_LINES];
+    spinlock_t lock;
+    bool enabled;
+    u32 count;
+    u32 latency;
+    u64 vnow;
+    struct emul_line lines[EMUL_MAX_LINES];
+};
+
+static struct irqgen_emul emul;
+static struct irq_domain *emul_domain;
+static struct fwnode_handle *emul_fwnode;
+static struct platform_device *emul_pdev;
+
+static inline u64 emul_now(void)
+{
+    return vtime ? emul.vnow : ktime_get_ns();
+}
+
+// Due time of the next IRQ of a line
+static inline u64 emul_due(const struct emul_line *l)
+{
+    return l->start_ns + l->next * l->delay_ns;
+}
+
+// Raise the next IRQ of a line: runs under emul.lock.
+// Returns the IRQ to raise once the lock is released, 0 if none.
+static unsigned int emul_raise(struct emul_line *l)
+{
+    if (!emul.enabled || l->in_flight || l->next >= l->amount)
+        return 0;
+
+    l->due_ns = emul_due(l);
+    ++l->next;
+    l->in_flight = true;
+    ++emul.count;
+    return l->virq;
+}
+
+// Arm the timer of the next IRQ of a line, or raise it right away with
+// vtime: runs under emul.lock
+static unsigned int emul_schedule(struct emul_line *l)
+{
+    if (l->next >= l->amount)
+        return 0;
+    if (vtime)
+        return emul_raise(l);
+
+    hrtimer_start(&l->timer, ns_to_ktime(emul_due(l)), HRTIMER_MODE_ABS_HARD);
+    return 0;
+}
+
+static void emul_fire(unsigned int virq)
+{
+    if (0 != virq)
+        irq_set_irqchip_state(virq, IRQCHIP_STATE_PENDING, true);
+}
+
+static enum hrtimer_restart emul_timer(struct hrtimer *t)
+{
+    struct emul_line *l = container_of(t, struct emul_line, timer);
+    unsigned long flags;
+    unsigned int virq;
+
+    spin_lock_irqsave(&emul.lock, flags);
+    virq = emul_raise(l);
+    spin_unlock_irqrestore(&emul.lock, flags);
+
+    emul_fire(virq);
+    return HRTIMER_NORESTART;
+}
+
+// A write of IRQGEN_GENIRQ_REG: a new command supersedes the one of its
+// line, and an amount of 0 stops all of them. Runs under emul.lock.
+static unsigned int emul_genirq(u32 value)
+{
+    u32 amount = FIELD_GET(IRQGEN_GENIRQ_REG_F_AMOUNT, value);
+    u32 line = FIELD_GET(IRQGEN_GENIRQ_REG_F_LINE, value);
+    struct emul_line *l;
+    int i;
+
+    if (0 == amount) {
+        for (i = 0; i < lines; ++i)
+            emul.lines[i].amount = 0;
+        return 0;
+    }
+    if (line >= lines)
+        return 0;
+
+    l = &emul.lines[line];
+    l->amount = amount;
+    l->next = 0;
+    l->delay_ns = (u64)FIELD_GET(IRQGEN_GENIRQ_REG_F_DELAY, value) * FPGA_CLOCK_NS;
+    l->start_ns = emul_now();
+    // The IRQ in flight, if any, still has to be acknowledged
+    return l->in_flight ? 0 : emul_schedule(l);
+}
+
+// A write of IRQGEN_CTRL_REG acknowledging an IRQ. Runs under emul.lock.
+static unsigned int emul_ack(u32 ack)
+{
+    struct emul_line *l;
+    u64 now;
+    int i;
+
+    for (i = 0; i < lines; ++i)
+        if (emul.acks[i] == ack && emul.lines[i].in_flight)
+            break;
+    if (i == lines)
+        return 0;
+
+    l = &emul.lines[i];
+    if (vtime)
+        emul.vnow = max(emul.vnow, l->due_ns) + vtime_service_ns;
+    now = emul_now();
+    emul.latency = div_u64(now > l->due_ns ? now - l->due_ns : 0, FPGA_CLOCK_NS);
+    l->in_flight = false;
+
+    return emul_schedule(l);
+}
+
+u32 irqgen_emul_read(void __iomem *addr)
+{
+    unsigned long offset = (unsigned long)((u32 __force *)addr - emul.regs) * sizeof(u32);
+    unsigned long flags;
+    u32 value = 0;
+
+    spin_lock_irqsave(&emul.lock, flags);
+    switch (offset) {
+    case IRQGEN_CTRL_REG_OFFSET:
+        value = FIELD_PREP(IRQGEN_CTRL_REG_F_ENABLE, emul.enabled);
+        break;
+    case IRQGEN_IRQ_COUNT_REG_OFFSET:
+        value = emul.count;
+        break;
+    case IRQGEN_LATENCY_REG_OFFSET:
+        value = emul.latency;
+        break;
+    }
+    spin_unlock_irqrestore(&emul.lock, flags);
+
+    return value;
+}
+EXPORT_SYMBOL_GPL(irqgen_emul_read);
+
+void irqgen_emul_write(u32 value, void __iomem *addr)
+{
+    unsigned long offset = (unsigned long)((u32 __force *)addr - emul.regs) * sizeof(u32);
+    unsigned long flags;
+    unsigned int virq = 0;
+    int i;
+
+    spin_lock_irqsave(&emul.lock, flags);
+    switch (offset) {
+    case IRQGEN_CTRL_REG_OFFSET:
+        emul.enabled = FIELD_GET(IRQGEN_CTRL_REG_F_ENABLE, value);
+        if (FIELD_GET(IRQGEN_CTRL_REG_F_HANDLED, value))
+            virq = emul_ack(FIELD_GET(IRQGEN_CTRL_REG_F_ACK, value));
+        if (!emul.enabled)
+            for (i = 0; i < lines; ++i)
+                emul.lines[i].amount = 0;
+        break;
+    case IRQGEN_GENIRQ_REG_OFFSET:
+        virq = emul_genirq(value);
+        break;
+    }
+    spin_unlock_irqrestore(&emul.lock, flags);
+
+    emul_fire(virq);
+}
+EXPORT_SYMBOL_GPL(irqgen_emul_write);
+
+void __iomem *irqgen_emul_regs(void)
+{
+    return (void __iomem __force *)emul.regs;
+}
+EXPORT_SYMBOL_GPL(irqgen_emul_regs);
+
+static int32_t __init irqgen_emul_init(void)
+{
+    struct resource res[EMUL_MAX_LINES];
+    struct property_entry props[] = {
+        PROPERTY_ENTRY_U32_ARRAY_LEN("wapice,intrack", emul.acks, lines),
+        { }
+    };
+    struct platform_device_info info = {
+        .name = DRIVER_NAME,
+        .id = PLATFORM_DEVID_NONE,
+        .res = res,
+        .num_res = lines,
+        .properties = props,
+    };
+    int retval, i;
+
+    if (0 == lines || lines > EMUL_MAX_LINES) {
+        printk(KERN_ERR KMSG_PFX "lines parameter out of range (1-%d).\n", EMUL_MAX_LINES);
+        return -EINVAL;
+    }
+
+    spin_lock_init(&emul.lock);
+
+    emul_fwnode = irq_domain_alloc_named_fwnode(DRIVER_NAME "-emul");
+    if (!emul_fwnode)
+        return -ENOMEM;
+    emul_domain = irq_domain_create_sim(emul_fwnode, lines);
+    if (IS_ERR(emul_domain)) {
+        printk(KERN_ERR KMSG_PFX "irq_domain_create_sim() failed.\n");
+        retval = PTR_ERR(emul_domain);
+        goto err_domain;
+    }
+
+    for (i = 0; i < lines; ++i) {
+        struct emul_line *l = &emul.lines[i];
+
+        l->virq = irq_create_mapping(emul_domain, i);
+        if (0 == l->virq) {
+            retval = -ENXIO;
+            goto err_mapping;
+        }
+        hrtimer_init(&l->timer, CLOCK_MONOTONIC, HRTIMER_MODE_ABS_HARD);
+        l->timer.function = emul_timer;
+        // Distinct 4-bit ack values, as in the device tree of the board
+        emul.acks[i] = i + 1;
+        res[i] = (struct resource)DEFINE_RES_IRQ(l->virq);
+    }
+
+    emul_pdev = platform_device_register_full(&info);
+    if (IS_ERR(emul_pdev)) {
+        printk(KERN_ERR KMSG_PFX "platform_device_register_full() failed.\n");
+        retval = PTR_ERR(emul_pdev);
+        goto err_mapping;
+    }
+
+    printk(KERN_INFO KMSG_PFX "%u lines emulated%s.\n", lines, vtime ? " in virtual time" : "");
+    return 0;
+
+ err_mapping:
+    while (i-- > 0)
+        irq_dispose_mapping(emul.lines[i].virq);
+    irq_domain_remove_sim(emul_domain);
+ err_domain:
+    irq_domain_free_fwnode(emul_fwnode);
+    return retval;
+}
+
+static void __exit irqgen_emul_exit(void)
+{
+    int i;
+
+    platform_device_unregister(emul_pdev);
+    for (i = 0; i < lines; ++i) {
+        hrtimer_cancel(&emul.lines[i].timer);
+        irq_dispose_mapping(emul.lines[i].virq);
+    }
+    irq_domain_remove_sim(emul_domain);
+    irq_domain_free_fwnode(emul_fwnode);
+}
+
+module_init(irqgen_emul_init);
+module_exit(irqgen_emul_exit);
+
+MODULE_LICENSE("GPL");
+MODULE_DESCRIPTION("Software emulation of the IRQ Generator IP block, for irqgen.ko built with IRQGEN_EMUL=y");
+MODULE_VERSION("0.7");
@@ -0,0 +1,104 @@
+/**
+ * @file   irqgen_filter.c
+ * @date   17 October 2026
+ * @target_device Xilinx PYNQ-Z1
+ * @brief   Per-line decimation of the samples pushed by irqgen.ko to the
+ *          latencies buffer.
+ */
+
+# include <linux/kernel.h>           // Contains types, macros, functions for the kernel
+# include <linux/string.h>
+# include <linux/random.h>           // get_random_u32
+
+# include "irqgen.h"                 // Shared module specific declarations
+
+# define PROB_SCALE 1000000          // IRQGEN_FILTER_PROB param is in ppm
+
+static const char * const irqgen_filter_names[] = {
+    [IRQGEN_FILTER_ALL]   = "all",
+    [IRQGEN_FILTER_NTH]   = "nth",
+    [IRQGEN_FILTER_PROB]  = "prob",
+    [IRQGEN_FILTER_ABOVE] = "above",
+};
+
+// Slow path of irqgen_filter_keep(), for any mode other than "all"
+bool __irqgen_filter_keep(struct irqgen_filter *f, u32 latency)
+{
+    bool keep;
+
+    switch (f->mode) {
+    case IRQGEN_FILTER_NTH:
+        keep = (++f->count >= f->param);
+        if (keep)
+            f->count = 0;
+        break;
+    case IRQGEN_FILTER_PROB:
+        keep = (get_random_u32() < f->prob);
+        break;
+    case IRQGEN_FILTER_ABOVE:
+        keep = (latency > f->param);
+        break;
+    default:
+        keep = true;
+    }
+
+    if (!keep)
+        ++f->filtered;
+    return keep;
+}
+
+// Configure the filter of a line, from a mode name and its parameter
+int irqgen_filter_set(int line, const char *mode, u32 param)
+{
+    struct irqgen_filter f = { 0 };
+    int m;
+
+    if (line < 0 || line >= irqgen_data->line_count)
+        return -ERANGE;
+
+    for (m = 0; m < ARRAY_SIZE(irqgen_filter_names); ++m)
+        if (0 == strcmp(mode, irqgen_filter_names[m]))
+            break;
+    if (m == ARRAY_SIZE(irqgen_filter_names))
+        return -EINVAL;
+
+    f.mode = m;
+    f.param = param;
+    switch (m) {
+    case IRQGEN_FILTER_NTH:
+        if (0 == param)
+            return -ERANGE;
+        break;
+    case IRQGEN_FILTER_PROB:
+        if (param > PROB_SCALE)
+            return -ERANGE;
+        f.prob = div_u64((u64)param * U32_MAX, PROB_SCALE);
+        break;
+    }
+
+    spin_lock_irq(&irqgen_data->data_lock);
+    f.filtered = irqgen_data->filters[line].filtered;
+    irqgen_data->filters[line] = f;
+    spin_unlock_irq(&irqgen_data->data_lock);
+
+    return 0;
+}
+
+// One line per IRQ line: "<line> <mode> <param> <filtered>"
+ssize_t irqgen_filter_show(char *buf)
+{
+    ssize_t acc = 0;
+    int i;
+
+    for (i = 0; i < irqgen_data->line_count; ++i) {
+        struct irqgen_filter f;
+
+        spin_lock_irq(&irqgen_data->data_lock);
+        f = irqgen_data->filters[i];
+        spin_unlock_irq(&irqgen_data->data_lock);
+
+        acc += scnprintf(buf + acc, PAGE_SIZE - acc, "%d %s %u %u\n",
+                         i, irqgen_filter_names[f.mode], f.param, f.filtered);
+    }
+    return acc;
+}
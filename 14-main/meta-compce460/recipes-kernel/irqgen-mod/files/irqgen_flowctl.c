@@ -0,0 +1,145 @@
+/**
+ * @file   irqgen_flowctl.c
+ * @date   17 October 2026
+ * @target_device Xilinx PYNQ-Z1
+ * @brief   Flow control of irqgen.ko: pauses the IRQ Generator while the
+ *          latencies buffer is too full for the reader.
+ */
+
+# include <linux/kernel.h>           // Contains types, macros, functions for the kernel
+# include <linux/ktime.h>            // ktime_get_ns
+
+# include "irqgen.h"                 // Shared module specific declarations
+
+/*
+ * The backlog reached the high watermark: runs inside the critical section
+ * of the interrupt handler, with `next` the command from the ring the
+ * handler was about to write (amount 0 if none) and `pingpong` whether it
+ * was about to issue the next ping-pong IRQ.
+ * The generation is stopped, and the command to write when resuming is
+ * saved: `next` or the ping-pong IRQ if any, else the rest of the batch of
+ * `line`.
+ */
+void __irqgen_flowctl_pause(int line, u64 now, struct irqgen_cmd *next, bool pingpong)
+{
+    // Without IRQGEN_CONFIG_BATCHES there is no batch to resume
+    static const struct irqgen_batch none;
+    struct irqgen_flowctl *fc = &irqgen_data->flowctl;
+    const struct irqgen_batch *b = irqgen_data->batches ? &irqgen_data->batches[line] : &none;
+
+    fc->paused = true;
+    fc->paused_at = now;
+    ++fc->pauses;
+
+    if (0 != next->amount) {
+        fc->resume = *next;
+    } else if (pingpong) {
+        // The ping-pong state is kept without IRQGEN_CONFIG_BATCHES as well
+        fc->resume.amount = 1;
+        fc->resume.line = line;
+        fc->resume.delay = irqgen_data->pingpong.delay;
+        fc->resume.batch = b->id;
+    } else if (b->handled < b->amount) {
+        fc->resume.amount = min_t(u32, b->amount - b->handled, IRQGEN_MAX_AMOUNT);
+        fc->resume.line = line;
+        fc->resume.delay = b->delay;
+        fc->resume.batch = b->id;
+    } else {
+        fc->resume.amount = 0;
+    }
+
+    // The handler stops the generator as disable_irq_generator() does
+    next->amount = 0;
+}
+
+static void flowctl_log(struct irqgen_flowctl *fc, u64 now)
+{
+    struct irqgen_pause *p = &fc->log[fc->log_wp];
+
+    p->start_ns = fc->paused_at;
+    p->duration_ns = now - fc->paused_at;
+    fc->log_wp = (fc->log_wp + 1) % IRQGEN_FLOWCTL_LOG;
+    fc->paused_ns += p->duration_ns;
+    fc->paused = false;
+}
+
+/*
+ * Resume the generation if paused and the backlog is down to the low
+ * watermark (or unconditionally if `force`): runs with the data_lock held.
+ * Returns whether `cmd` holds a command to write to the IRQ Generator.
+ */
+bool irqgen_flowctl_resume(struct irqgen_cmd *cmd, bool force)
+{
+    struct irqgen_flowctl *fc = &irqgen_data->flowctl;
+
+    if (!fc->paused || (!force && irqgen_flowctl_backlog() > fc->low))
+        return false;
+
+    flowctl_log(fc, ktime_get_ns());
+    *cmd = fc->resume;
+
+    return 0 != cmd->amount;
+}
+
+/*
+ * Set the watermarks, in samples, and enable the flow control, or disable
+ * it if `high` is 0. A pending pause is resumed when disabling.
+ */
+int irqgen_flowctl_set(u32 high, u32 low)
+{
+    struct irqgen_flowctl *fc = &irqgen_data->flowctl;
+    struct irqgen_cmd cmd;
+    bool issue;
+
+    if (0 != high && (high >= MAX_LATENCIES || low >= high))
+        return -ERANGE;
+
+    spin_lock_irq(&irqgen_data->data_lock);
+    fc->high = high;
+    fc->low = low;
+    fc->enabled = 0 != high;
+    issue = irqgen_flowctl_resume(&cmd, !fc->enabled);
+    spin_unlock_irq(&irqgen_data->data_lock);
+
+    if (issue)
+        irqgen_issue(&cmd);
+
+    return 0;
+}
+
+/*
+ * Print "off", or "<high> <low> <paused> <pauses> <paused ns>" followed by
+ * the last pauses as "<start ns> <duration ns>", the oldest first
+ */
+ssize_t irqgen_flowctl_show(char *buf)
+{
+    struct irqgen_flowctl fc;
+    ssize_t len;
+    u64 paused_ns;
+    int i;
+
+    spin_lock_irq(&irqgen_data->data_lock);
+    fc = irqgen_data->flowctl;
+    spin_unlock_irq(&irqgen_data->data_lock);
+
+    paused_ns = fc.paused_ns;
+    if (fc.paused)
+        paused_ns += ktime_get_ns() - fc.paused_at;
+
+    if (fc.enabled)
+        len = scnprintf(buf, PAGE_SIZE, "%u %u %d %u %llu\n",
+                        fc.high, fc.low, fc.paused, fc.pauses, paused_ns);
+    else
+        len = scnprintf(buf, PAGE_SIZE, "off\n");
+
+    for (i = 0; i < IRQGEN_FLOWCTL_LOG; ++i) {
+        const struct irqgen_pause *p = &fc.log[(fc.log_wp + i) % IRQGEN_FLOWCTL_LOG];
+
+        if (0 == p->start_ns)
+            continue;
+        len += scnprintf(buf + len, PAGE_SIZE - len, "%llu %llu\n",
+                         p->start_ns, p->duration_ns);
+    }
+
+    return len;
+}
@@ -0,0 +1,70 @@
+/**
+ * @file   irqgen_hprof.c
+ * @date   17 October 2026
+ * @target_device Xilinx PYNQ-Z1
+ * @brief   Per-CPU profile of the self time of the interrupt handler of
+ *          irqgen.ko.
+ */
+
+# include <linux/kernel.h>           // Contains types, macros, functions for the kernel
+# include <linux/fs.h>               // Header for Linux file system support
+# include <linux/seq_file.h>         // Sequential files for debugfs output
+# include <linux/percpu.h>           // Per-CPU variables
+# include <linux/string.h>
+
+# include "irqgen.h"                 // Shared module specific declarations
+
+// Duration of the interrupt handler on each CPU, in ns. Only ever updated
+// by the handler running on the same CPU, with interrupts disabled
+static DEFINE_PER_CPU(struct irqgen_hist, irqgen_hprof);
+
+// Account the duration of one handler invocation on the local CPU
+void __irqgen_hprof_account(u64 ns)
+{
+    irqgen_hist_add(this_cpu_ptr(&irqgen_hprof), ns);
+}
+
+/*
+ * The "handler_profile" debugfs file: one line per CPU with
+ * "cpu<N> <count> <mean> <max>" followed by the histogram bins.
+ * Writing anything to it resets the counters.
+ */
+static int irqgen_hprof_show(struct seq_file *m, void *v)
+{
+    char name[16];
+    int cpu;
+
+    seq_printf(m, "# ns of local_clock(), bin i counts [2^(i-1), 2^i)\n");
+    for_each_possible_cpu(cpu) {
+        struct irqgen_hist h = *per_cpu_ptr(&irqgen_hprof, cpu);
+
+        snprintf(name, sizeof(name), "cpu%d", cpu);
+        irqgen_hist_show(m, name, &h);
+    }
+
+    return 0;
+}
+
+static int irqgen_hprof_open(struct inode *inode, struct file *f)
+{
+    return single_open(f, irqgen_hprof_show, NULL);
+}
+
+static ssize_t irqgen_hprof_write(struct file *f, const char __user *ubuf, size_t count, loff_t *ppos)
+{
+    int cpu;
+
+    for_each_possible_cpu(cpu)
+        memset(per_cpu_ptr(&irqgen_hprof, cpu), 0, sizeof(struct irqgen_hist));
+
+    return count;
+}
+
+const struct file_operations irqgen_hprof_fops = {
+    .owner = THIS_MODULE,
+    .open = irqgen_hprof_open,
+    .read = seq_read,
+    .write = irqgen_hprof_write,
+    .llseek = seq_lseek,
+    .release = single_release,
+};
@@ -12,7 +12,7 @@
 #include <linux/module.h>           // Core header for loading LKMs into the kern
 #include <linux/kernel.h>           // Contains types, macros, functions for the kernel
 #include <linux/platform_device.h>  // Platform device related functions
-#include <linux/of.h>               // Property reads from device tree
+#include <linux/property.h>         // Property reads from device tree or software nodes
 
 #include <linux/interrupt.h>        // Interrupt handling functions
 #include <asm/io.h>                 // IO operations
@@ -22,12 +22,19 @@
 
 
 #include "irqgen.h"                 // Shared module specific declarations
+#include "irqgen_consumer.h"        // In-kernel consumers of the events
+
+// Without IRQGEN_CONFIG_TRACE the tracepoints compile to empty inlines
+#ifdef IRQGEN_CONFIG_TRACE
+#define CREATE_TRACE_POINTS
+#else
+#define NOTRACE
+#endif
+#include "irqgen_trace.h"           // Tracepoints of the module
 
 #define PROP_COMPATIBLE "wapice,irq-gen"
 #define PROP_WAPICE_INTRACK "wapice,intrack"
 
-#define FPGA_CLOCK_NS   10 /* 1000 / FPGA_CLOCK_MHZ */
-
 // Kernel token address to access the IRQ Generator core register
 void __iomem *irqgen_reg_base = NULL;
 
@@ -37,6 +44,10 @@ struct irqgen_data *irqgen_data = NULL;
 // Platform driver structure (initialized at the end of the file)
 static struct platform_driver irqgen_pdriver;
 
+// Runtime switches for the optional code paths
+DEFINE_STATIC_KEY_FALSE(irqgen_debug_key);
+DEFINE_STATIC_KEY_TRUE(irqgen_instr_key);
+
 /* vvvv ---- LKM Parameters vvvv ---- */
 static unsigned int generate_irqs = 0;
 module_param(generate_irqs, uint, 0444);
@@ -68,105 +79,294 @@ static int parse_parameters(void)
 // Returns the latency of last successfully served IRQ, in clock cycles
 static inline u32 irqgen_read_latency_clk(void)
 {
-    return ioread32(IRQGEN_LATENCY_REG);
+    return irqgen_ioread32(IRQGEN_LATENCY_REG);
 }
 
 // Push a new latency value to the circular buffer: runs inside the
-// critical section of the interrupt handler
-static inline
-void irqgen_data_push_latency(int line, u32 latency, u64 timestamp)
+// critical section of the interrupt handler.
+// Returns the line of the unread sample overwritten to make room, or -1.
+static inline int irqgen_data_push_latency(const struct latency_data *s)
 {
     int wp, rp;
-    struct latency_data s = {
-        .latency = latency,
-        .line = (u8)line,
-        .timestamp = timestamp
-    };
+    int evicted = -1;
 
     wp = irqgen_data->wp;
     rp = irqgen_data->rp;
 
-    irqgen_data->latencies[wp] = s;
+    irqgen_data->latencies[wp] = *s;
     wp = (wp+1)%MAX_LATENCIES;
+    if (0 == wp)
+        irqgen_data->wrapped = true;
     if (wp == rp) {
+        evicted = irqgen_data->latencies[rp].line;
+        ++irqgen_data->dropped;
         rp = (rp+1)%MAX_LATENCIES;
     }
 
     irqgen_data->wp = wp;
     irqgen_data->rp = rp;
+
+    return evicted;
+}
+
+// Write a generation command to the IRQ Generator
+static inline void irqgen_write_genirq(u16 amount, u8 line, u16 delay)
+{
+    u32 regvalue = 0
+                   | FIELD_PREP(IRQGEN_GENIRQ_REG_F_AMOUNT,  amount)
+                   | FIELD_PREP(IRQGEN_GENIRQ_REG_F_DELAY,    delay)
+                   | FIELD_PREP(IRQGEN_GENIRQ_REG_F_LINE,      line);
+
+    irqgen_iowrite32(regvalue, IRQGEN_GENIRQ_REG);
+}
+
+// Account a handled IRQ for the ping-pong mode: runs inside the critical
+// section of the interrupt handler.
+// Returns whether the next ping-pong IRQ has to be generated, and with
+// which delay.
+static inline bool irqgen_pingpong_next(int line, u16 *delay)
+{
+    struct irqgen_pingpong *pp = &irqgen_data->pingpong;
+
+    if (likely(!pp->active) || line != pp->line)
+        return false;
+
+    ++pp->completed;
+    if (--pp->remaining > 0) {
+        *delay = pp->delay;
+        return true;
+    }
+
+    pp->active = false;
+    return false;
 }
 
 static irqreturn_t irqgen_irqhandler(int irq, void *data)
 {
+    u64 entry = irqgen_hprof_enter();
+    u64 pmu[IRQGEN_PMU_EVENTS];
     u64 timestamp;
     u32 idx, ack, latency=0, regvalue;
-
+    int cpu = smp_processor_id();
+    int evicted = -1;
+    bool filtered, keep, pingpong, wake = false, chan_wake = false, pause, pmu_sampled;
+    u16 pingpong_delay = 0;
+    u32 batch, batch_idx;
+    u8 flags;
+    struct irqgen_cmd next = { .amount = 0 };
+
+    pmu_sampled = irqgen_pmu_enter(pmu);
     timestamp = ktime_get_ns();
     idx = *(const u32 *)data;
     ack = irqgen_data->intr_acks[idx];
-    regvalue = ioread32(IRQGEN_CTRL_REG);
+    regvalue = irqgen_ioread32(IRQGEN_CTRL_REG);
     regvalue &= ~(IRQGEN_CTRL_REG_F_HANDLED | IRQGEN_CTRL_REG_F_ACK);
     regvalue |= 0
                 | FIELD_PREP(IRQGEN_CTRL_REG_F_HANDLED, 1)
                 | FIELD_PREP(IRQGEN_CTRL_REG_F_ACK, (ack));
 
-# ifdef DEBUG
-    printk(KERN_INFO KMSG_PFX "IRQ #%d (idx: %d) received (ACK 0x%0X).\n", irq, idx, ack);
-# endif
+    if (static_branch_unlikely(&irqgen_debug_key))
+        printk_ratelimited(KERN_INFO KMSG_PFX "IRQ #%d (idx: %d) received (ACK 0x%0X).\n", irq, idx, ack);
 
-    iowrite32(regvalue, IRQGEN_CTRL_REG);
+    irqgen_iowrite32(regvalue, IRQGEN_CTRL_REG);
 
     latency = irqgen_read_latency_clk();
 
-    // TODO: handle concurrency
-	//first using spin lock to prevent the other code from accessing shared data 
-    spin_lock_irq(&irqgen_data->data_lock);
+    // Interrupts are already disabled in the handler: a plain spin_lock()
+    // protects the shared data without re-enabling them on unlock
+    spin_lock(&irqgen_data->data_lock);
     // {{{ CRITICAL SECTION
     ++irqgen_data->total_handled;
     ++irqgen_data->intr_handled[idx];
-    irqgen_data_push_latency(idx, latency, timestamp);
+    flags = irqgen_data->sample_flags;
+    batch = irqgen_batch_next(idx, timestamp, &batch_idx, &next);
+    filtered = irqgen_filter_keep(idx, latency);
+    // The trigger freezes the merged ring: it waits while the ring is off
+    keep = irqgen_data->merged && irqgen_trigger_keep(timestamp, latency, filtered);
+    if (keep || (filtered && irqgen_chan_active(idx))) {
+        u64 now = static_branch_likely(&irqgen_instr_key) ? ktime_get_ns() : timestamp;
+        u32 baseline = irqgen_calib_baseline();
+        struct latency_data s = {
+            .latency = latency - min(latency, baseline),
+            .line = (u8)idx,
+            .cpu = (u8)cpu,
+            .timestamp = timestamp,
+            .flags = flags,
+#ifdef IRQGEN_CONFIG_STATS
+            .publish_ns = now - timestamp,
+#endif
+#ifdef IRQGEN_CONFIG_BATCHES
+            .batch = batch,
+            .idx = batch_idx,
+#endif
+        };
+
+        // Corrected stream: the MMIO cost measured by the calibration is
+        // removed once, so every reader sees the same latency
+        if (0 != baseline)
+            s.flags |= IRQGEN_SAMPLE_CORRECTED;
+
+        if (keep) {
+            evicted = irqgen_data_push_latency(&s);
+            if (irqgen_data_pending() >= irqgen_data->wakeup_threshold &&
+                wq_has_sleeper(&irqgen_data->readq)) {
+                irqgen_data->last_wake_ns = now;
+                wake = true;
+            }
+        }
+        if (filtered)
+            chan_wake = irqgen_chan_push(idx, &s);
+    }
+    irqgen_stats_update(idx, latency, timestamp, evicted);
+    irqgen_balance_account(idx, cpu, latency);
+    if (static_branch_likely(&irqgen_instr_key))
+        irqgen_rollup_account(idx, latency, timestamp, evicted);
+    pingpong = irqgen_pingpong_next(idx, &pingpong_delay);
+    pause = irqgen_flowctl_check(idx, timestamp, &next, pingpong);
     // }}}
-	//unlocking the data to allow other code to access
-    spin_unlock_irq(&irqgen_data->data_lock);
+    spin_unlock(&irqgen_data->data_lock);
+
+    if (wake)
+        wake_up_interruptible(&irqgen_data->readq);
+    if (chan_wake)
+        wake_up_interruptible(&irqgen_data->chans[idx].readq);
+
+    if (trace_irqgen_sample_enabled()) {
+        struct irqgen_sample s = {
+            .timestamp = timestamp,
+            .latency = latency,
+            .line = idx,
+            .cpu = cpu,
+            .batch = batch,
+            .idx = batch_idx,
+            .flags = flags
+        };
+
+        trace_irqgen_sample(&s, keep);
+    }
 
+    if (irqgen_consumers_active()) {
+        struct irqgen_event e = {
+            .timestamp = timestamp,
+            .latency = latency,
+            .line = idx,
+            .cpu = cpu,
+            .batch = batch,
+            .idx = batch_idx,
+            .flags = flags
+        };
+
+        __irqgen_consumers_dispatch(&e);
+    }
+
+    // The latencies buffer is full: stop until the readers catch up
+    if (pause)
+        irqgen_write_genirq(0, 0, 0);
+    // The previous IRQ is already acknowledged: issue the next one
+    if (pingpong && !pause)
+        irqgen_write_genirq(1, idx, pingpong_delay);
+    // The previous batch is complete: issue the next one from the ring
+    if (0 != next.amount)
+        irqgen_issue(&next);
+
+    irqgen_pmu_exit(pmu_sampled, idx, pmu);
+    irqgen_hprof_exit(entry);
     return IRQ_HANDLED;
 }
 
 /* Enable the IRQ Generator */
 void enable_irq_generator(void)
 {
-#ifdef DEBUG
-    printk(KERN_INFO KMSG_PFX "Enabling IRQ Generator.\n");
-#endif
     u32 regvalue = FIELD_PREP(IRQGEN_CTRL_REG_F_ENABLE, 1);
-    iowrite32(regvalue, IRQGEN_CTRL_REG);
+
+    pr_debug(KMSG_PFX "Enabling IRQ Generator.\n");
+    irqgen_iowrite32(regvalue, IRQGEN_CTRL_REG);
 }
 
 /* Disable the IRQ Generator */
 void disable_irq_generator(void)
 {
-#ifdef DEBUG
-    printk(KERN_INFO KMSG_PFX "Disabling IRQ Generator.\n");
-#endif
     u32 regvalue = FIELD_PREP(IRQGEN_CTRL_REG_F_ENABLE, 0);
-    iowrite32(regvalue, IRQGEN_CTRL_REG);
+    struct irqgen_cmd resume;
+
+    pr_debug(KMSG_PFX "Disabling IRQ Generator.\n");
+    irqgen_pingpong_stop();
+    irqgen_ring_stop();
+
+    // End a pause of the flow control, without resuming the generation
+    spin_lock_irq(&irqgen_data->data_lock);
+    irqgen_flowctl_resume(&resume, true);
+    spin_unlock_irq(&irqgen_data->data_lock);
+    irqgen_iowrite32(regvalue, IRQGEN_CTRL_REG);
 
     regvalue = FIELD_PREP(IRQGEN_GENIRQ_REG_F_AMOUNT,  0);
-    iowrite32(regvalue, IRQGEN_GENIRQ_REG);
+    irqgen_iowrite32(regvalue, IRQGEN_GENIRQ_REG);
 }
 
 /* Generate specified amount of interrupts on specified IRQ_F2P line [IRQLINES_AMNT-1:0] */
 void do_generate_irqs(uint16_t amount, uint8_t line, uint16_t delay)
 {
-    u32 regvalue = 0
-                   | FIELD_PREP(IRQGEN_GENIRQ_REG_F_AMOUNT,  amount)
-                   | FIELD_PREP(IRQGEN_GENIRQ_REG_F_DELAY,    delay)
-                   | FIELD_PREP(IRQGEN_GENIRQ_REG_F_LINE,      line);
+    struct irqgen_cmd c = {
+        .amount = amount,
+        .line = line,
+        .delay = delay,
+        .batch = irqgen_batch_start(line, amount, delay)
+    };
+
+    irqgen_issue(&c);
+}
+
+// Write a command whose batch is already started
+void irqgen_issue(const struct irqgen_cmd *c)
+{
+    trace_irqgen_generate(c->amount, c->line, c->delay, c->batch);
+
+    irqgen_write_genirq(c->amount, c->line, c->delay);
+}
+
+/*
+ * Start a ping-pong run of `iterations` IRQs on `line`: only one IRQ is in
+ * flight at any time, so that the latency does not include the queueing
+ * behind the previous IRQ as it does with amount > 1
+ */
+int irqgen_pingpong_start(u8 line, u16 delay, u32 iterations)
+{
+    struct irqgen_pingpong *pp = &irqgen_data->pingpong;
+    struct irqgen_cmd c = {
+        .amount = 1,
+        .line = line,
+        .delay = delay
+    };
+
+    if (line >= irqgen_data->line_count || delay > IRQGEN_MAX_DELAY)
+        return -ERANGE;
+    if (0 == iterations)
+        return -EINVAL;
 
-    printk(KERN_DEBUG KMSG_PFX "Generating %u interrupts with IRQ delay %u on line %d.\n",
-           amount, delay, line);
+    spin_lock_irq(&irqgen_data->data_lock);
+    if (pp->active) {
+        spin_unlock_irq(&irqgen_data->data_lock);
+        return -EBUSY;
+    }
+    pp->active = true;
+    pp->line = line;
+    pp->delay = delay;
+    pp->remaining = iterations;
+    pp->completed = 0;
+    spin_unlock_irq(&irqgen_data->data_lock);
 
-    iowrite32(regvalue, IRQGEN_GENIRQ_REG);
+    // The whole run is a single batch
+    c.batch = irqgen_batch_start(line, iterations, delay);
+    irqgen_issue(&c);
+    return 0;
+}
+
+// Stop a ping-pong run: the IRQ in flight, if any, is still handled
+void irqgen_pingpong_stop(void)
+{
+    spin_lock_irq(&irqgen_data->data_lock);
+    irqgen_data->pingpong.active = false;
+    spin_unlock_irq(&irqgen_data->data_lock);
 }
 
 // Returns the latency of last successfully served IRQ, in ns
@@ -179,21 +379,17 @@ u64 irqgen_read_latency(void)
 // Returns the total generated IRQ count from IRQ_GEN_IRQ_COUNT_REG
 u32 irqgen_read_count(void)
 {
-    return ioread32(IRQGEN_IRQ_COUNT_REG);
+    return irqgen_ioread32(IRQGEN_IRQ_COUNT_REG);
 }
 
-// Debugging wrapper for devm_request_irq()
-#ifdef DEBUG
+// Debugging wrapper for devm_request_irq(), enabled through dynamic debug
 static
 int _devm_request_irq(struct device *_dev, unsigned int _irq, irq_handler_t _handler, unsigned long _flags, const char *_name, void *_data)
 {
-    printk(KERN_DEBUG KMSG_PFX "devm_request_irq(%p, %u, %p, %lu, %s, %p)\n",
-            _dev, _irq, _handler, _flags, _name, _data);
+    pr_debug(KMSG_PFX "devm_request_irq(%p, %u, %p, %lu, %s, %p)\n",
+             _dev, _irq, _handler, _flags, _name, _data);
     return devm_request_irq(_dev, _irq, _handler, _flags, _name, _data);
 }
-#else
-# define _devm_request_irq devm_request_irq
-#endif
 
 // helper for devm_kzalloc()
 #define DEVM_KZALLOC_HELPER(_var,_pdev,_cnt,_flags) \
@@ -213,17 +409,28 @@ static int irqgen_probe(struct platform_device *pdev)
     int retval = 0;
     int i;
     int irqs_count = 0, irqs_acks = 0;
+#ifndef IRQGEN_CONFIG_EMUL
     struct resource *iomem_range = NULL;
+#endif
 
     DEVM_KZALLOC_HELPER(irqgen_data, pdev, 1, GFP_KERNEL);
+#ifdef IRQGEN_CONFIG_SAMPLES
     DEVM_KZALLOC_HELPER(irqgen_data->latencies, pdev, MAX_LATENCIES, GFP_KERNEL);
+#endif
 
     // TODO: how to protect the shared r/w members of irqgen_data
     //using spinlock to protect the read/write access of irqgen_data
     spin_lock_init(&irqgen_data->data_lock);
+    init_waitqueue_head(&irqgen_data->readq);
+    irqgen_data->wakeup_threshold = 1;
+    irqgen_data->merged = true;
 
 
 
+#ifdef IRQGEN_CONFIG_EMUL
+    // The emulated device has no register space to map
+    irqgen_reg_base = irqgen_emul_regs();
+#else
     iomem_range = platform_get_resource(pdev, IORESOURCE_MEM, 0);
     if (IS_ERR(iomem_range)) {
         printk(KERN_ERR KMSG_PFX "platform_get_resource(IORESOURCE_MEM) failed.\n");
@@ -239,9 +446,10 @@ static int irqgen_probe(struct platform_device *pdev)
         irqgen_reg_base = NULL;
         goto err;
     }
+#endif
 
     irqs_count = platform_irq_count(pdev);
-    irqs_acks = of_property_count_u32_elems(pdev->dev.of_node, PROP_WAPICE_INTRACK);
+    irqs_acks = device_property_count_u32(&pdev->dev, PROP_WAPICE_INTRACK);
 
     if (irqs_count <= 0) {
         printk(KERN_ERR KMSG_PFX
@@ -270,10 +478,20 @@ static int irqgen_probe(struct platform_device *pdev)
                         pdev, irqs_count, GFP_KERNEL);
     DEVM_KZALLOC_HELPER(irqgen_data->intr_handled,
                         pdev, irqs_count, GFP_KERNEL);
+#ifdef IRQGEN_CONFIG_BATCHES
+    DEVM_KZALLOC_HELPER(irqgen_data->batches,
+                        pdev, irqs_count, GFP_KERNEL);
+#endif
+#ifdef IRQGEN_CONFIG_SAMPLES
+    DEVM_KZALLOC_HELPER(irqgen_data->filters,
+                        pdev, irqs_count, GFP_KERNEL);
+    DEVM_KZALLOC_HELPER(irqgen_data->chans,
+                        pdev, irqs_count, GFP_KERNEL);
+#endif
 
     irqgen_data->line_count = irqs_count;
-    retval = of_property_read_u32_array(pdev->dev.of_node, PROP_WAPICE_INTRACK,
-                                        irqgen_data->intr_acks, irqs_count);
+    retval = device_property_read_u32_array(&pdev->dev, PROP_WAPICE_INTRACK,
+                                            irqgen_data->intr_acks, irqs_count);
     if (retval) {
         printk(KERN_ERR KMSG_PFX
                "Failed to read interrupt ack values from the device tree with %d.\n",
@@ -281,6 +499,54 @@ static int irqgen_probe(struct platform_device *pdev)
         goto err;
     }
 
+    retval = irqgen_rollup_setup(pdev);
+    if (0 != retval) {
+        printk(KERN_ERR KMSG_PFX "Rollup setup failed.\n");
+        goto err;
+    }
+
+    retval = irqgen_stats_setup(pdev);
+    if (0 != retval) {
+        printk(KERN_ERR KMSG_PFX "Stats page setup failed.\n");
+        goto err;
+    }
+
+    retval = irqgen_ring_setup(pdev);
+    if (0 != retval) {
+        printk(KERN_ERR KMSG_PFX "Submission ring setup failed.\n");
+        goto err;
+    }
+
+    retval = irqgen_notify_setup(pdev);
+    if (0 != retval) {
+        printk(KERN_ERR KMSG_PFX "Notification setup failed.\n");
+        goto err;
+    }
+
+    retval = irqgen_pmu_setup(pdev);
+    if (0 != retval) {
+        printk(KERN_ERR KMSG_PFX "PMU setup failed.\n");
+        goto err;
+    }
+
+    retval = irqgen_balance_setup(pdev);
+    if (0 != retval) {
+        printk(KERN_ERR KMSG_PFX "Affinity balancer setup failed.\n");
+        goto err;
+    }
+
+    retval = irqgen_session_setup(pdev);
+    if (0 != retval) {
+        printk(KERN_ERR KMSG_PFX "Measurement session setup failed.\n");
+        goto err;
+    }
+
+    retval = irqgen_calib_setup(pdev);
+    if (0 != retval) {
+        printk(KERN_ERR KMSG_PFX "Calibration setup failed.\n");
+        goto err;
+    }
+
     for (i=0; i<irqs_count; ++i) {
         int irq_id = platform_get_irq(pdev, i);
 
@@ -326,8 +592,16 @@ static int irqgen_probe(struct platform_device *pdev)
         goto err_cdev_setup;
     }
 
+    retval = irqgen_debugfs_setup(pdev);
+    if (0 != retval) {
+        printk(KERN_ERR KMSG_PFX "debugfs setup failed.\n");
+        goto err_debugfs_setup;
+    }
+
     return 0;
 
+ err_debugfs_setup:
+    irqgen_cdev_cleanup(pdev);
  err_cdev_setup:
     irqgen_sysfs_cleanup(pdev);
  err_sysfs_setup:
@@ -338,8 +612,12 @@ static int irqgen_probe(struct platform_device *pdev)
 
 static int irqgen_remove(struct platform_device *pdev)
 {
+    irqgen_debugfs_cleanup(pdev);
     irqgen_cdev_cleanup(pdev);
     irqgen_sysfs_cleanup(pdev);
+    irqgen_pmu_cleanup(pdev);
+    irqgen_balance_cleanup(pdev);
+    irqgen_session_cleanup(pdev);
 
     return 0;
 }
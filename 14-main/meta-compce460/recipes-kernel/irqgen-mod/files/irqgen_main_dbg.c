@@ -1 +0,0 @@
-irqgen_main.c
\ No newline at end of file
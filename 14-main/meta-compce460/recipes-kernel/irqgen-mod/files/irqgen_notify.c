@@ -0,0 +1,78 @@
+/**
+ * @file   irqgen_notify.c
+ * @date   17 October 2026
+ * @target_device Xilinx PYNQ-Z1
+ * @brief   Completion notification of the generation batches of
+ *          irqgen.ko: eventfd, poll() priority data and sysfs.
+ */
+
+# include <linux/kernel.h>           // Contains types, macros, functions for the kernel
+# include <linux/eventfd.h>          // Signalling eventfds from the handler
+# include <linux/workqueue.h>        // Deferred sysfs_notify()
+# include <linux/sysfs.h>
+
+# include "irqgen.h"                 // Shared module specific declarations
+
+/* The members below must be protected by irqgen_data->data_lock */
+static struct eventfd_ctx *done_eventfd = NULL;
+
+// sysfs_notify() may sleep: it cannot be called from the handler
+static void irqgen_notify_work_fn(struct work_struct *work)
+{
+    irqgen_sysfs_notify("batches");
+}
+static DECLARE_WORK(irqgen_notify_work, irqgen_notify_work_fn);
+
+/*
+ * A batch was completed: runs inside the critical section of the interrupt
+ * handler. The eventfd is signalled right away, the pollers of /dev/irqgen
+ * and of the "batches" attribute shortly after.
+ */
+void irqgen_notify_done(const struct irqgen_batch *b)
+{
+    irqgen_data->last_done = *b;
+    ++irqgen_data->done_seq;
+
+    if (NULL != done_eventfd)
+        eventfd_signal(done_eventfd, 1);
+    if (wq_has_sleeper(&irqgen_data->readq))
+        wake_up_interruptible(&irqgen_data->readq);
+    schedule_work(&irqgen_notify_work);
+}
+
+/*
+ * Register the eventfd `fd` to be signalled on each completed batch, or
+ * unregister the current one if `fd` is negative
+ */
+int irqgen_notify_set_eventfd(int fd)
+{
+    struct eventfd_ctx *ctx = NULL, *old;
+
+    if (fd >= 0) {
+        ctx = eventfd_ctx_fdget(fd);
+        if (IS_ERR(ctx))
+            return PTR_ERR(ctx);
+    }
+
+    spin_lock_irq(&irqgen_data->data_lock);
+    old = done_eventfd;
+    done_eventfd = ctx;
+    spin_unlock_irq(&irqgen_data->data_lock);
+
+    if (NULL != old)
+        eventfd_ctx_put(old);
+
+    return 0;
+}
+
+static void irqgen_notify_flush(void *data)
+{
+    cancel_work_sync(&irqgen_notify_work);
+}
+
+// Must be called before requesting the IRQs: devm then flushes the pending
+// notification only after the handlers are released
+int irqgen_notify_setup(struct platform_device *pdev)
+{
+    return devm_add_action_or_reset(&pdev->dev, irqgen_notify_flush, NULL);
+}
@@ -0,0 +1,98 @@
+/**
+ * @file   irqgen_pipeline.c
+ * @date   17 October 2026
+ * @target_device Xilinx PYNQ-Z1
+ * @brief   End-to-end latency of the samples of irqgen.ko, from the
+ *          interrupt handler to the read() of /dev/irqgen.
+ */
+
+# include <linux/kernel.h>           // Contains types, macros, functions for the kernel
+# include <linux/fs.h>               // Header for Linux file system support
+# include <linux/seq_file.h>         // Sequential files for debugfs output
+# include <linux/string.h>
+
+# include "irqgen.h"                 // Shared module specific declarations
+
+/*
+ * Delays between an IRQ and the consumption of its sample by a reader of
+ * /dev/irqgen, in ns:
+ *
+ * @pipeline_queue: from the sample becoming visible to its read, only with
+ *                  IRQGEN_CONFIG_STATS which stamps the samples with it
+ * @pipeline_e2e: from the start of the handler to the read
+ * @pipeline_wakeup: from the wakeup of a waiting reader to its next read
+ *
+ * The members below must be protected by irqgen_data->data_lock
+ */
+static struct irqgen_hist pipeline_queue;
+static struct irqgen_hist pipeline_e2e;
+static struct irqgen_hist pipeline_wakeup;
+
+// A reader entered read(): account the delay since it was woken, if it was
+void irqgen_pipeline_woken(u64 now)
+{
+    u64 woken = irqgen_data->last_wake_ns;
+
+    if (0 == woken)
+        return;
+    irqgen_data->last_wake_ns = 0;
+    irqgen_hist_add(&pipeline_wakeup, now > woken ? now - woken : 0);
+}
+
+// A reader consumed a sample
+void irqgen_pipeline_consumed(const struct latency_data *s, u64 now)
+{
+#ifdef IRQGEN_CONFIG_STATS
+    u64 visible = s->timestamp + s->publish_ns;
+
+    irqgen_hist_add(&pipeline_queue, now > visible ? now - visible : 0);
+#endif
+    irqgen_hist_add(&pipeline_e2e, now > s->timestamp ? now - s->timestamp : 0);
+}
+
+/*
+ * The "pipeline" debugfs file: the three histograms, in ns.
+ * Writing anything to it resets them.
+ */
+static int irqgen_pipeline_show(struct seq_file *m, void *v)
+{
+    struct irqgen_hist queue, e2e, wakeup;
+
+    spin_lock_irq(&irqgen_data->data_lock);
+    queue = pipeline_queue;
+    e2e = pipeline_e2e;
+    wakeup = pipeline_wakeup;
+    spin_unlock_irq(&irqgen_data->data_lock);
+
+    seq_printf(m, "# ns, bin i counts [2^(i-1), 2^i)\n");
+    irqgen_hist_show(m, "queue", &queue);
+    irqgen_hist_show(m, "e2e", &e2e);
+    irqgen_hist_show(m, "wakeup", &wakeup);
+
+    return 0;
+}
+
+static int irqgen_pipeline_open(struct inode *inode, struct file *f)
+{
+    return single_open(f, irqgen_pipeline_show, NULL);
+}
+
+static ssize_t irqgen_pipeline_write(struct file *f, const char __user *ubuf, size_t count, loff_t *ppos)
+{
+    spin_lock_irq(&irqgen_data->data_lock);
+    memset(&pipeline_queue, 0, sizeof(pipeline_queue));
+    memset(&pipeline_e2e, 0, sizeof(pipeline_e2e));
+    memset(&pipeline_wakeup, 0, sizeof(pipeline_wakeup));
+    spin_unlock_irq(&irqgen_data->data_lock);
+
+    return count;
+}
+
+const struct file_operations irqgen_pipeline_fops = {
+    .owner = THIS_MODULE,
+    .open = irqgen_pipeline_open,
+    .read = seq_read,
+    .write = irqgen_pipeline_write,
+    .llseek = seq_lseek,
+    .release = single_release,
+};
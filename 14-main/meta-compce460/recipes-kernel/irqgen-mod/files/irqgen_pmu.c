@@ -0,0 +1,232 @@
+/**
+ * @file   irqgen_pmu.c
+ * @date   17 October 2026
+ * @target_device Xilinx PYNQ-Z1
+ * @brief   Hardware PMU counters sampled by irqgen.ko around its interrupt
+ *          handler.
+ */
+
+# include <linux/kernel.h>           // Contains types, macros, functions for the kernel
+# include <linux/fs.h>               // Header for Linux file system support
+# include <linux/seq_file.h>         // Sequential files for debugfs output
+# include <linux/percpu.h>           // Per-CPU variables
+# include <linux/cpu.h>              // CPU hotplug locking
+# include <linux/mutex.h>
+# include <linux/rcupdate.h>         // synchronize_rcu
+# include <linux/math64.h>           // 64-bit divisions
+# include <linux/perf_event.h>       // Kernel perf counters
+
+# include "irqgen.h"                 // Shared module specific declarations
+
+DEFINE_STATIC_KEY_FALSE(irqgen_pmu_key);
+
+static const struct {
+    const char *name;
+    u64 config;
+} irqgen_pmu_events[IRQGEN_PMU_EVENTS] = {
+    { "instructions",  PERF_COUNT_HW_INSTRUCTIONS },
+    { "cache-misses",  PERF_COUNT_HW_CACHE_MISSES },
+    { "branch-misses", PERF_COUNT_HW_BRANCH_MISSES },
+};
+
+// The counters of one CPU, NULL where they could not be created
+struct irqgen_pmu_cpu {
+    struct perf_event *ev[IRQGEN_PMU_EVENTS];
+};
+static DEFINE_PER_CPU(struct irqgen_pmu_cpu, irqgen_pmu_cpu);
+
+/*-
+ * Counter deltas over the handler invocations of one IRQ line
+ *
+ * @count: number of handler invocations measured
+ * @sum: sum of the deltas of each counter, for the mean
+ * @bins: log2 histogram of the deltas of each counter
+ */
+struct irqgen_pmu_line {
+    u64 count;
+    u64 sum[IRQGEN_PMU_EVENTS];
+    u32 bins[IRQGEN_PMU_EVENTS][IRQGEN_PMU_BINS];
+};
+
+// The handlers of one line never run concurrently: each line has a
+// single writer and needs no lock
+static struct irqgen_pmu_line *irqgen_pmu_lines = NULL;
+
+static DEFINE_MUTEX(irqgen_pmu_mutex);
+static bool irqgen_pmu_enabled = false;
+
+static inline u64 pmu_read(struct perf_event *ev)
+{
+    u64 value = 0;
+
+    if (ev)
+        perf_event_read_local(ev, &value, NULL, NULL);
+    return value;
+}
+
+// Read the counters of the local CPU at handler entry
+void __irqgen_pmu_enter(u64 *values)
+{
+    struct irqgen_pmu_cpu *c = this_cpu_ptr(&irqgen_pmu_cpu);
+    int i;
+
+    for (i = 0; i < IRQGEN_PMU_EVENTS; ++i)
+        values[i] = pmu_read(c->ev[i]);
+}
+
+// Read the counters again at handler exit and account the deltas
+void __irqgen_pmu_exit(int line, const u64 *values)
+{
+    struct irqgen_pmu_cpu *c = this_cpu_ptr(&irqgen_pmu_cpu);
+    struct irqgen_pmu_line *l = &irqgen_pmu_lines[line];
+    u64 now[IRQGEN_PMU_EVENTS];
+    int i;
+
+    for (i = 0; i < IRQGEN_PMU_EVENTS; ++i)
+        now[i] = pmu_read(c->ev[i]);
+
+    for (i = 0; i < IRQGEN_PMU_EVENTS; ++i) {
+        u64 delta = now[i] - values[i];
+
+        l->sum[i] += delta;
+        ++l->bins[i][irqgen_log2_bin(delta, IRQGEN_PMU_BINS)];
+    }
+    ++l->count;
+}
+
+static void pmu_release_all(void)
+{
+    int cpu, i;
+
+    for_each_possible_cpu(cpu) {
+        struct irqgen_pmu_cpu *c = per_cpu_ptr(&irqgen_pmu_cpu, cpu);
+
+        for (i = 0; i < IRQGEN_PMU_EVENTS; ++i) {
+            if (c->ev[i])
+                perf_event_release_kernel(c->ev[i]);
+            c->ev[i] = NULL;
+        }
+    }
+}
+
+// Create the counters on every online CPU, then switch the sampling on
+int irqgen_pmu_enable(void)
+{
+    int retval = 0;
+    int cpu, i;
+
+    mutex_lock(&irqgen_pmu_mutex);
+    if (irqgen_pmu_enabled)
+        goto out;
+
+    cpus_read_lock();
+    for_each_online_cpu(cpu) {
+        struct irqgen_pmu_cpu *c = per_cpu_ptr(&irqgen_pmu_cpu, cpu);
+
+        for (i = 0; i < IRQGEN_PMU_EVENTS; ++i) {
+            struct perf_event_attr attr = {
+                .type = PERF_TYPE_HARDWARE,
+                .size = sizeof(attr),
+                .config = irqgen_pmu_events[i].config,
+                .pinned = 1,
+            };
+            struct perf_event *ev;
+
+            ev = perf_event_create_kernel_counter(&attr, cpu, NULL, NULL, NULL);
+            if (IS_ERR(ev)) {
+                printk(KERN_ERR KMSG_PFX "Creating the %s counter on CPU %d failed with %ld.\n",
+                       irqgen_pmu_events[i].name, cpu, PTR_ERR(ev));
+                retval = PTR_ERR(ev);
+                cpus_read_unlock();
+                pmu_release_all();
+                goto out;
+            }
+            c->ev[i] = ev;
+        }
+    }
+    cpus_read_unlock();
+
+    static_branch_enable(&irqgen_pmu_key);
+    // Start from clean statistics once the handlers that were already
+    // running, and did not read the counters, have completed
+    synchronize_rcu();
+    memset(irqgen_pmu_lines, 0, irqgen_data->line_count * sizeof(*irqgen_pmu_lines));
+    irqgen_pmu_enabled = true;
+
+ out:
+    mutex_unlock(&irqgen_pmu_mutex);
+    return retval;
+}
+
+// Switch the sampling off, then release the counters once no handler can
+// be using them anymore
+void irqgen_pmu_disable(void)
+{
+    mutex_lock(&irqgen_pmu_mutex);
+    if (irqgen_pmu_enabled) {
+        static_branch_disable(&irqgen_pmu_key);
+        // Interrupt handlers are RCU read-side critical sections
+        synchronize_rcu();
+        pmu_release_all();
+        irqgen_pmu_enabled = false;
+    }
+    mutex_unlock(&irqgen_pmu_mutex);
+}
+
+bool irqgen_pmu_is_enabled(void)
+{
+    return irqgen_pmu_enabled;
+}
+
+int irqgen_pmu_setup(struct platform_device *pdev)
+{
+    irqgen_pmu_lines = devm_kcalloc(&pdev->dev, irqgen_data->line_count,
+                                    sizeof(*irqgen_pmu_lines), GFP_KERNEL);
+    if (NULL == irqgen_pmu_lines) {
+        printk(KERN_ERR KMSG_PFX "Allocation of irqgen_pmu_lines failed.\n");
+        return -ENOMEM;
+    }
+    return 0;
+}
+
+void irqgen_pmu_cleanup(struct platform_device *pdev)
+{
+    irqgen_pmu_disable();
+}
+
+/*
+ * The "pmu" debugfs file: for each line and counter, "line<N> <counter>
+ * <count> <mean>" followed by the log2 histogram bins of the deltas.
+ */
+static int irqgen_pmu_show(struct seq_file *m, void *v)
+{
+    int line, i, b;
+
+    for (line = 0; line < irqgen_data->line_count; ++line) {
+        const struct irqgen_pmu_line *l = &irqgen_pmu_lines[line];
+        u64 count = READ_ONCE(l->count);
+
+        for (i = 0; i < IRQGEN_PMU_EVENTS; ++i) {
+            seq_printf(m, "line%d %s %llu %llu", line, irqgen_pmu_events[i].name,
+                       count, count ? div64_u64(l->sum[i], count) : 0);
+            for (b = 0; b < IRQGEN_PMU_BINS; ++b)
+                seq_printf(m, " %u", l->bins[i][b]);
+            seq_putc(m, '\n');
+        }
+    }
+
+    return 0;
+}
+
+static int irqgen_pmu_open(struct inode *inode, struct file *f)
+{
+    return single_open(f, irqgen_pmu_show, NULL);
+}
+
+const struct file_operations irqgen_pmu_fops = {
+    .owner = THIS_MODULE,
+    .open = irqgen_pmu_open,
+    .read = seq_read,
+    .llseek = seq_lseek,
+    .release = single_release,
+};
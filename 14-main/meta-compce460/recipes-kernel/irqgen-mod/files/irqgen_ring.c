@@ -0,0 +1,252 @@
+/**
+ * @file   irqgen_ring.c
+ * @date   17 October 2026
+ * @target_device Xilinx PYNQ-Z1
+ * @brief   Submission and completion rings of irqgen.ko, shared with
+ *          userspace through mmap() of /dev/irqgen.
+ */
+
+# include <linux/kernel.h>           // Contains types, macros, functions for the kernel
+# include <linux/fs.h>               // Header for Linux file system support
+# include <linux/mm.h>               // struct vm_area_struct
+# include <linux/vmalloc.h>          // vmalloc_user/remap_vmalloc_range
+
+# include "irqgen.h"                 // Shared module specific declarations
+
+/*-
+ * Submission and completion rings shared with userspace through mmap() of
+ * /dev/irqgen, see struct irqgen_ring_hdr
+ *
+ * Only the kernel side of each index is trusted: the ones written by
+ * userspace are re-read and checked on each use.
+ *
+ * @mem: the vmalloc_user() area mapped by userspace
+ * @size: size of @mem in bytes
+ * @hdr: the header at the beginning of @mem
+ * @sqes: the submission queue entries
+ * @cqes: the completion queue entries
+ * @sq_head: next submission to consume
+ * @cq_tail: next completion to post
+ * @batch: ID of the batch issued from the submission queue and still in
+ *         flight, 0 if the ring is idle
+ * @line: the IRQ line of @batch
+ * @user_data: the user_data of the submission of @batch
+ * @flags: the flags of the submission of @batch
+ */
+struct irqgen_ring {
+    void *mem;
+    size_t size;
+    struct irqgen_ring_hdr *hdr;
+    struct irqgen_sqe *sqes;
+    struct irqgen_cqe *cqes;
+    u32 sq_head;
+    u32 cq_tail;
+    u32 batch;
+    u8  line;
+    u64 user_data;
+    u8  flags;
+};
+
+/* The members below must be protected by irqgen_data->data_lock */
+static struct irqgen_ring ring;
+
+static void ring_post(u64 user_data, u32 batch, s32 res, u64 issued_ns, u64 done_ns)
+{
+    struct irqgen_ring_hdr *hdr = ring.hdr;
+    struct irqgen_cqe *cqe;
+
+    if (ring.cq_tail - smp_load_acquire(&hdr->cq_head) >= IRQGEN_RING_CQ_ENTRIES) {
+        WRITE_ONCE(hdr->cq_overflow, hdr->cq_overflow + 1);
+        return;
+    }
+
+    cqe = &ring.cqes[ring.cq_tail & (IRQGEN_RING_CQ_ENTRIES - 1)];
+    cqe->user_data = user_data;
+    cqe->batch = batch;
+    cqe->res = res;
+    cqe->issued_ns = issued_ns;
+    cqe->done_ns = done_ns;
+    smp_store_release(&hdr->cq_tail, ++ring.cq_tail);
+}
+
+static inline void ring_set_need_wakeup(bool on)
+{
+    u32 flags = READ_ONCE(ring.hdr->flags);
+
+    if (on)
+        flags |= IRQGEN_RING_NEED_WAKEUP;
+    else
+        flags &= ~IRQGEN_RING_NEED_WAKEUP;
+    WRITE_ONCE(ring.hdr->flags, flags);
+}
+
+/*
+ * Consume submissions until a valid one is found and start its batch.
+ * Returns whether `next` holds a command to write to the IRQ Generator.
+ * When the queue is empty, userspace is asked for a IRQGEN_IOC_RING_ENTER.
+ *
+ * Runs in the interrupt handler: at most IRQGEN_RING_SQ_ENTRIES entries
+ * are looked at per call, however fast userspace queues invalid ones. The
+ * rest waits for the next IRQGEN_IOC_RING_ENTER.
+ */
+static bool ring_pop(struct irqgen_cmd *next)
+{
+    struct irqgen_ring_hdr *hdr = ring.hdr;
+    struct irqgen_sqe sqe;
+    u32 budget = IRQGEN_RING_SQ_ENTRIES;
+    u32 tail;
+
+ again:
+    tail = smp_load_acquire(&hdr->sq_tail);
+    if (tail - ring.sq_head > IRQGEN_RING_SQ_ENTRIES) {
+        // A corrupted tail: drop whatever was queued
+        ring.sq_head = tail;
+        smp_store_release(&hdr->sq_head, ring.sq_head);
+    }
+
+    while (ring.sq_head != tail && budget > 0) {
+        --budget;
+        sqe = ring.sqes[ring.sq_head & (IRQGEN_RING_SQ_ENTRIES - 1)];
+        smp_store_release(&hdr->sq_head, ++ring.sq_head);
+
+        if (sqe.line >= irqgen_data->line_count || 0 == sqe.amount ||
+            sqe.amount > IRQGEN_MAX_AMOUNT || sqe.delay > IRQGEN_MAX_DELAY) {
+            if (!(sqe.flags & IRQGEN_SQE_SKIP_CQE))
+                ring_post(sqe.user_data, 0, -EINVAL, 0, 0);
+            continue;
+        }
+
+        next->amount = sqe.amount;
+        next->line = sqe.line;
+        next->delay = sqe.delay;
+        next->batch = __irqgen_batch_start(sqe.line, sqe.amount, sqe.delay);
+
+        ring.batch = next->batch;
+        ring.line = sqe.line;
+        ring.user_data = sqe.user_data;
+        ring.flags = sqe.flags;
+        ring_set_need_wakeup(false);
+        return true;
+    }
+
+    // Pairs with the barrier between the update of sq_tail and the read of
+    // the flags in userspace: either side sees the other's update. The
+    // re-check shares the budget, so it cannot loop without bound.
+    ring_set_need_wakeup(true);
+    smp_mb();
+    if (budget > 0 && smp_load_acquire(&hdr->sq_tail) != ring.sq_head)
+        goto again;
+
+    return false;
+}
+
+/*
+ * A batch was completed: runs inside the critical section of the interrupt
+ * handler. If it came from the submission queue, post its completion and
+ * start the next submission.
+ * Returns whether `next` holds a command to write to the IRQ Generator.
+ */
+bool irqgen_ring_done(const struct irqgen_batch *b, struct irqgen_cmd *next)
+{
+    if (NULL == ring.hdr || 0 == ring.batch || b->id != ring.batch)
+        return false;
+
+    if (!(ring.flags & IRQGEN_SQE_SKIP_CQE))
+        ring_post(ring.user_data, b->id, 0, b->issued_ns, b->done_ns);
+    ring.batch = 0;
+
+    return ring_pop(next);
+}
+
+// The batch in flight from the submission queue will not complete: the
+// ring stays idle until the next IRQGEN_IOC_RING_ENTER
+static void ring_cancel(const struct irqgen_batch *b)
+{
+    if (!(ring.flags & IRQGEN_SQE_SKIP_CQE))
+        ring_post(ring.user_data, b->id, -ECANCELED, b->issued_ns, 0);
+    ring.batch = 0;
+    ring_set_need_wakeup(true);
+}
+
+// A batch is replaced by a new command on its line before completing:
+// runs with the data_lock held
+void irqgen_ring_superseded(const struct irqgen_batch *b)
+{
+    if (NULL != ring.hdr && 0 != ring.batch && b->id == ring.batch)
+        ring_cancel(b);
+}
+
+// The IRQ Generator is being disabled
+void irqgen_ring_stop(void)
+{
+    if (NULL == ring.hdr)
+        return;
+
+    spin_lock_irq(&irqgen_data->data_lock);
+    if (0 != ring.batch)
+        ring_cancel(&irqgen_data->batches[ring.line]);
+    spin_unlock_irq(&irqgen_data->data_lock);
+}
+
+// IRQGEN_IOC_RING_ENTER: start consuming the submission queue, if idle
+int irqgen_ring_enter(void)
+{
+    struct irqgen_cmd next;
+    bool issue = false;
+
+    // While the flow control pauses the generator, the ring resumes with it
+    spin_lock_irq(&irqgen_data->data_lock);
+    if (0 == ring.batch && !irqgen_data->flowctl.paused)
+        issue = ring_pop(&next);
+    spin_unlock_irq(&irqgen_data->data_lock);
+
+    if (issue)
+        irqgen_issue(&next);
+
+    return 0;
+}
+
+int irqgen_ring_mmap(struct file *f, struct vm_area_struct *vma)
+{
+    if (0 != vma->vm_pgoff)
+        return -EINVAL;
+
+    return remap_vmalloc_range(vma, ring.mem, 0);
+}
+
+static void ring_vfree(void *p)
+{
+    ring.hdr = NULL;
+    vfree(p);
+}
+
+// Must be called before requesting the IRQs: the handler uses the rings
+int irqgen_ring_setup(struct platform_device *pdev)
+{
+    struct irqgen_ring_hdr *hdr;
+    size_t sq_off = ALIGN(sizeof(*hdr), sizeof(u64));
+    size_t cq_off = sq_off + IRQGEN_RING_SQ_ENTRIES * sizeof(struct irqgen_sqe);
+
+    ring.size = PAGE_ALIGN(cq_off + IRQGEN_RING_CQ_ENTRIES * sizeof(struct irqgen_cqe));
+    ring.mem = vmalloc_user(ring.size);
+    if (NULL == ring.mem) {
+        printk(KERN_ERR KMSG_PFX "Allocation of the submission rings failed.\n");
+        return -ENOMEM;
+    }
+
+    hdr = ring.mem;
+    hdr->sq_entries = IRQGEN_RING_SQ_ENTRIES;
+    hdr->sq_off = sq_off;
+    hdr->cq_entries = IRQGEN_RING_CQ_ENTRIES;
+    hdr->cq_off = cq_off;
+    hdr->flags = IRQGEN_RING_NEED_WAKEUP;
+
+    ring.sqes = ring.mem + sq_off;
+    ring.cqes = ring.mem + cq_off;
+    ring.sq_head = 0;
+    ring.cq_tail = 0;
+    ring.batch = 0;
+    ring.hdr = hdr;
+
+    return devm_add_action_or_reset(&pdev->dev, ring_vfree, ring.mem);
+}
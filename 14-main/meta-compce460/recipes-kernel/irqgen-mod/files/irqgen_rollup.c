@@ -0,0 +1,246 @@
+/**
+ * @file   irqgen_rollup.c
+ * @date   17 October 2026
+ * @target_device Xilinx PYNQ-Z1
+ * @brief   Time-windowed rollups of the IRQs handled by irqgen.ko and of
+ *          their latencies.
+ */
+
+# include <linux/kernel.h>           // Contains types, macros, functions for the kernel
+# include <linux/fs.h>               // Header for Linux file system support
+# include <linux/vmalloc.h>          // vzalloc/vfree
+# include <linux/math64.h>           // 64-bit divisions
+# include <linux/ktime.h>            // ktime_get_ns
+
+# include "irqgen.h"                 // Shared module specific declarations
+
+/*-
+ * Counters of one IRQ line during one time window
+ *
+ * See struct irqgen_rollup_rec for the meaning of the fields.
+ */
+struct irqgen_rollup_cell {
+    u32 handled;
+    u32 dropped;
+    u32 lat_min;
+    u32 lat_max;
+    u64 lat_sum;
+    u32 bins[IRQGEN_ROLLUP_BINS];
+};
+
+/*-
+ * Ring of fixed-width time windows
+ *
+ * @width_ns: width of each window
+ * @start_ns: timestamp in ns of the beginning of the current window
+ * @cur: index of the current window
+ * @cells: IRQGEN_ROLLUP_SLOTS windows of line_count cells each
+ */
+struct irqgen_rollup {
+    u64 width_ns;
+    u64 start_ns;
+    int cur;
+    struct irqgen_rollup_cell *cells;
+};
+
+static const u64 irqgen_rollup_widths[] = {
+    1 * NSEC_PER_SEC,
+    60 * NSEC_PER_SEC,
+};
+#define ROLLUP_COUNT ARRAY_SIZE(irqgen_rollup_widths)
+
+/* The members below must be protected by irqgen_data->data_lock */
+static struct irqgen_rollup irqgen_rollups[ROLLUP_COUNT];
+
+static inline size_t rollup_slot_cells(void)
+{
+    return irqgen_data->line_count;
+}
+
+static inline
+struct irqgen_rollup_cell *rollup_cell(struct irqgen_rollup *r, int slot, int line)
+{
+    return &r->cells[slot * rollup_slot_cells() + line];
+}
+
+// Move the current window forward so that it contains `now`, clearing the
+// windows skipped on the way
+static void rollup_advance(struct irqgen_rollup *r, u64 now)
+{
+    u64 steps;
+
+    if (now < r->start_ns + r->width_ns)
+        return;
+
+    steps = div64_u64(now - r->start_ns, r->width_ns);
+    r->start_ns += steps * r->width_ns;
+
+    if (steps > IRQGEN_ROLLUP_SLOTS)
+        steps = IRQGEN_ROLLUP_SLOTS;
+    while (steps--) {
+        r->cur = (r->cur + 1) % IRQGEN_ROLLUP_SLOTS;
+        memset(rollup_cell(r, r->cur, 0), 0,
+               rollup_slot_cells() * sizeof(*r->cells));
+    }
+}
+
+// Account a handled IRQ (and the sample it evicted from the latency buffer,
+// if any): runs inside the critical section of the interrupt handler
+void irqgen_rollup_account(int line, u32 latency, u64 timestamp, int evicted)
+{
+    int i;
+
+    for (i = 0; i < ROLLUP_COUNT; ++i) {
+        struct irqgen_rollup *r = &irqgen_rollups[i];
+        struct irqgen_rollup_cell *c;
+
+        rollup_advance(r, timestamp);
+
+        c = rollup_cell(r, r->cur, line);
+        if (!c->handled || latency < c->lat_min)
+            c->lat_min = latency;
+        if (latency > c->lat_max)
+            c->lat_max = latency;
+        c->lat_sum += latency;
+        ++c->bins[irqgen_log2_bin(latency, IRQGEN_ROLLUP_BINS)];
+        ++c->handled;
+
+        if (evicted >= 0)
+            ++rollup_cell(r, r->cur, evicted)->dropped;
+    }
+}
+
+static void rollup_vfree(void *p)
+{
+    vfree(p);
+}
+
+int irqgen_rollup_setup(struct platform_device *pdev)
+{
+    int retval = 0;
+    int i;
+    u64 now = ktime_get_ns(), rem;
+
+    for (i = 0; i < ROLLUP_COUNT; ++i) {
+        struct irqgen_rollup *r = &irqgen_rollups[i];
+
+        // The IRQ handlers are released by devm after remove(): tie the
+        // lifetime of the windows to the device as well
+        r->cells = vzalloc(IRQGEN_ROLLUP_SLOTS * rollup_slot_cells() * sizeof(*r->cells));
+        if (NULL == r->cells) {
+            printk(KERN_ERR KMSG_PFX "Allocation of rollup windows failed.\n");
+            return -ENOMEM;
+        }
+        retval = devm_add_action_or_reset(&pdev->dev, rollup_vfree, r->cells);
+        if (0 != retval)
+            return retval;
+
+        r->width_ns = irqgen_rollup_widths[i];
+        div64_u64_rem(now, r->width_ns, &rem);
+        r->start_ns = now - rem;
+        r->cur = 0;
+    }
+
+    return 0;
+}
+
+/*
+ * The "rollups" debugfs file: the whole set of windows is captured at open()
+ * time, so that the content is consistent however it gets split in reads.
+ */
+static int irqgen_rollup_open(struct inode *inode, struct file *f)
+{
+    struct irqgen_snapshot *snap;
+    struct irqgen_rollup_hdr *hdr;
+    struct irqgen_rollup_rec *rec;
+    struct irqgen_rollup_cell *raw;
+    struct irqgen_rollup copy[ROLLUP_COUNT];
+    size_t ncells = IRQGEN_ROLLUP_SLOTS * rollup_slot_cells();
+    size_t size = sizeof(*hdr) + ROLLUP_COUNT * ncells * sizeof(*rec);
+    int i, k, line;
+
+    snap = irqgen_snapshot_alloc(size);
+    raw = vmalloc(ROLLUP_COUNT * ncells * sizeof(*raw));
+    if (NULL == snap || NULL == raw) {
+        vfree(snap);
+        vfree(raw);
+        return -ENOMEM;
+    }
+    hdr = (struct irqgen_rollup_hdr *)snap->data;
+    rec = (struct irqgen_rollup_rec *)(hdr + 1);
+
+    // The first lock hold fixes the windows reported, their cells are
+    // copied afterwards one window per lock hold and formatted last
+    spin_lock_irq(&irqgen_data->data_lock);
+    hdr->now_ns = ktime_get_ns();
+    for (i = 0; i < ROLLUP_COUNT; ++i) {
+        rollup_advance(&irqgen_rollups[i], hdr->now_ns);
+        copy[i] = irqgen_rollups[i];
+        copy[i].cells = raw + i * ncells;
+    }
+    spin_unlock_irq(&irqgen_data->data_lock);
+
+    for (i = 0; i < ROLLUP_COUNT; ++i) {
+        struct irqgen_rollup *r = &copy[i];
+
+        // Oldest window first: if the handler moves on meanwhile, it only
+        // recycles windows already copied
+        for (k = 1; k <= IRQGEN_ROLLUP_SLOTS; ++k) {
+            int slot = (r->cur + k) % IRQGEN_ROLLUP_SLOTS;
+            size_t len = rollup_slot_cells() * sizeof(*raw);
+            u64 moved;
+
+            spin_lock_irq(&irqgen_data->data_lock);
+            moved = div64_u64(irqgen_rollups[i].start_ns - r->start_ns, r->width_ns);
+            if (moved < k)
+                memcpy(rollup_cell(r, slot, 0), rollup_cell(&irqgen_rollups[i], slot, 0), len);
+            spin_unlock_irq(&irqgen_data->data_lock);
+
+            // Recycled before its turn (a copy slower than a window)
+            if (moved >= k)
+                memset(rollup_cell(r, slot, 0), 0, len);
+        }
+    }
+
+    hdr->magic = IRQGEN_ROLLUP_MAGIC;
+    hdr->version = IRQGEN_ROLLUP_VERSION;
+    hdr->bins = IRQGEN_ROLLUP_BINS;
+    hdr->line_count = irqgen_data->line_count;
+    hdr->count = ROLLUP_COUNT * ncells;
+
+    for (i = 0; i < ROLLUP_COUNT; ++i) {
+        struct irqgen_rollup *r = &copy[i];
+
+        // Oldest window first: the one right after the current one
+        for (k = 1; k <= IRQGEN_ROLLUP_SLOTS; ++k) {
+            int slot = (r->cur + k) % IRQGEN_ROLLUP_SLOTS;
+            u64 start = r->start_ns - (IRQGEN_ROLLUP_SLOTS - k) * r->width_ns;
+
+            for (line = 0; line < irqgen_data->line_count; ++line, ++rec) {
+                struct irqgen_rollup_cell *c = rollup_cell(r, slot, line);
+
+                rec->start_ns = start;
+                rec->width_ns = r->width_ns;
+                rec->line = line;
+                rec->handled = c->handled;
+                rec->dropped = c->dropped;
+                rec->lat_min = c->lat_min;
+                rec->lat_max = c->lat_max;
+                rec->lat_sum = c->lat_sum;
+                memcpy(rec->bins, c->bins, sizeof(rec->bins));
+            }
+        }
+    }
+    vfree(raw);
+
+    f->private_data = snap;
+    return 0;
+}
+
+const struct file_operations irqgen_rollup_fops = {
+    .owner = THIS_MODULE,
+    .open = irqgen_rollup_open,
+    .read = irqgen_snapshot_read,
+    .release = irqgen_snapshot_release,
+    .llseek = default_llseek,
+};
@@ -0,0 +1,216 @@
+/**
+ * @file   irqgen_session.c
+ * @date   17 October 2026
+ * @target_device Xilinx PYNQ-Z1
+ * @brief   Low-latency measurement sessions of irqgen.ko: CPU latency
+ *          constraints and frequency pinning while measuring.
+ */
+
+# include <linux/kernel.h>           // Contains types, macros, functions for the kernel
+# include <linux/fs.h>               // struct file
+# include <linux/cpu.h>              // get_cpu_device
+# include <linux/cpumask.h>
+# include <linux/cpufreq.h>          // Frequency QoS of the cpufreq policies
+# include <linux/pm_qos.h>           // CPU latency and device resume latency QoS
+# include <linux/irq.h>              // irq_get_affinity_mask
+# include <linux/mutex.h>
+# include <linux/slab.h>
+# include <linux/ktime.h>            // ktime_get_ns
+
+# include "irqgen.h"                 // Shared module specific declarations
+
+/*-
+ * A measurement session: constraints keeping the CPUs handling the IRQ
+ * lines out of deep idle states, and optionally at their top frequency,
+ * while a latency run is going on
+ *
+ * @active: whether the session is started
+ * @latency_us: the CPU latency and resume latency requested, in us
+ * @pin: whether the cpufreq policies are pinned to their top frequency
+ * @owner: the /dev/irqgen file which started the session, NULL if started
+ *         through sysfs
+ * @start_ns: timestamp in ns of the start of the session
+ * @sessions: number of sessions started
+ * @cpu_req: the system wide CPU latency request
+ * @cpus: the CPUs with a resume latency request
+ * @resume: resume latency requests, per CPU
+ * @pinned: the CPUs whose cpufreq policy has a frequency request
+ * @freq: minimum frequency requests, per CPU
+ */
+struct irqgen_session {
+    bool active;
+    s32 latency_us;
+    bool pin;
+    struct file *owner;
+    u64 start_ns;
+    u32 sessions;
+    struct pm_qos_request cpu_req;
+    cpumask_t cpus;
+    struct dev_pm_qos_request *resume;
+    cpumask_t pinned;
+    struct freq_qos_request *freq;
+};
+
+/* The members below are protected by irqgen_session_mutex */
+static DEFINE_MUTEX(irqgen_session_mutex);
+static struct irqgen_session session;
+
+// Drop every constraint taken, with irqgen_session_mutex held
+static void session_release(void)
+{
+    int cpu;
+
+    spin_lock_irq(&irqgen_data->data_lock);
+    irqgen_data->sample_flags &= ~IRQGEN_SAMPLE_SESSION;
+    spin_unlock_irq(&irqgen_data->data_lock);
+
+    for_each_cpu(cpu, &session.pinned)
+        freq_qos_remove_request(&session.freq[cpu]);
+    cpumask_clear(&session.pinned);
+    for_each_cpu(cpu, &session.cpus)
+        dev_pm_qos_remove_request(&session.resume[cpu]);
+    cpumask_clear(&session.cpus);
+    if (cpu_latency_qos_request_active(&session.cpu_req))
+        cpu_latency_qos_remove_request(&session.cpu_req);
+
+    session.active = false;
+    session.owner = NULL;
+}
+
+// Pin the cpufreq policy of `cpu` to its top frequency, once per policy
+static int session_pin(int cpu)
+{
+    struct cpufreq_policy *policy = cpufreq_cpu_get(cpu);
+    int other, retval;
+
+    if (NULL == policy)     // no cpufreq driver: nothing to pin
+        return 0;
+
+    for_each_cpu(other, &session.pinned) {
+        if (cpumask_test_cpu(other, policy->related_cpus)) {
+            cpufreq_cpu_put(policy);
+            return 0;
+        }
+    }
+
+    retval = freq_qos_add_request(&policy->constraints, &session.freq[cpu],
+                                  FREQ_QOS_MIN, policy->cpuinfo.max_freq);
+    cpufreq_cpu_put(policy);
+    if (retval < 0)
+        return retval;
+
+    cpumask_set_cpu(cpu, &session.pinned);
+    return 0;
+}
+
+/*
+ * Start a session: the CPU latency QoS and a resume latency constraint on
+ * each CPU the IRQ lines are affine to are set to `latency_us`, and with
+ * `pin` the cpufreq policies of those CPUs are held at their top frequency.
+ * The samples are tagged with IRQGEN_SAMPLE_SESSION until the session is
+ * stopped, by irqgen_session_stop() or by closing `owner` if not NULL.
+ */
+int irqgen_session_start(s32 latency_us, bool pin, struct file *owner)
+{
+    cpumask_t cpus;
+    int cpu, line, retval = 0;
+
+    if (latency_us < 0)
+        return -EINVAL;
+
+    cpumask_clear(&cpus);
+    for (line = 0; line < irqgen_data->line_count; ++line) {
+        const struct cpumask *m = irq_get_affinity_mask(irqgen_data->intr_ids[line]);
+
+        if (NULL != m)
+            cpumask_or(&cpus, &cpus, m);
+    }
+    cpumask_and(&cpus, &cpus, cpu_online_mask);
+
+    mutex_lock(&irqgen_session_mutex);
+    if (session.active) {
+        retval = -EBUSY;
+        goto out;
+    }
+
+    cpu_latency_qos_add_request(&session.cpu_req, latency_us);
+
+    for_each_cpu(cpu, &cpus) {
+        struct device *dev = get_cpu_device(cpu);
+
+        if (NULL == dev)
+            continue;
+        retval = dev_pm_qos_add_request(dev, &session.resume[cpu],
+                                        DEV_PM_QOS_RESUME_LATENCY, latency_us);
+        if (retval < 0)
+            goto err;
+        cpumask_set_cpu(cpu, &session.cpus);
+
+        if (pin) {
+            retval = session_pin(cpu);
+            if (0 != retval)
+                goto err;
+        }
+    }
+
+    session.active = true;
+    session.latency_us = latency_us;
+    session.pin = pin;
+    session.owner = owner;
+    session.start_ns = ktime_get_ns();
+    ++session.sessions;
+
+    spin_lock_irq(&irqgen_data->data_lock);
+    irqgen_data->sample_flags |= IRQGEN_SAMPLE_SESSION;
+    spin_unlock_irq(&irqgen_data->data_lock);
+
+    retval = 0;
+    goto out;
+
+ err:
+    printk(KERN_ERR KMSG_PFX "Setting the QoS constraints of CPU %d failed with %d.\n",
+           cpu, retval);
+    session_release();
+ out:
+    mutex_unlock(&irqgen_session_mutex);
+    return retval;
+}
+
+// Stop the session, if any and if started by `owner` (any if NULL)
+void irqgen_session_stop(struct file *owner)
+{
+    mutex_lock(&irqgen_session_mutex);
+    if (session.active && (NULL == owner || owner == session.owner))
+        session_release();
+    mutex_unlock(&irqgen_session_mutex);
+}
+
+// "<active> <latency us> <pin> <CPU list> <sessions> <ns since start>"
+ssize_t irqgen_session_show(char *buf)
+{
+    ssize_t len;
+
+    mutex_lock(&irqgen_session_mutex);
+    len = scnprintf(buf, PAGE_SIZE, "%u %d %u %*pbl %u %llu\n",
+                    session.active, session.latency_us, session.pin,
+                    cpumask_pr_args(&session.cpus), session.sessions,
+                    session.active ? ktime_get_ns() - session.start_ns : 0);
+    mutex_unlock(&irqgen_session_mutex);
+
+    return len;
+}
+
+int irqgen_session_setup(struct platform_device *pdev)
+{
+    session.resume = devm_kcalloc(&pdev->dev, nr_cpu_ids, sizeof(*session.resume), GFP_KERNEL);
+    session.freq = devm_kcalloc(&pdev->dev, nr_cpu_ids, sizeof(*session.freq), GFP_KERNEL);
+    if (NULL == session.resume || NULL == session.freq)
+        return -ENOMEM;
+
+    return 0;
+}
+
+void irqgen_session_cleanup(struct platform_device *pdev)
+{
+    irqgen_session_stop(NULL);
+}
@@ -0,0 +1,61 @@
+/**
+ * @file   irqgen_stats.c
+ * @date   17 October 2026
+ * @target_device Xilinx PYNQ-Z1
+ * @brief   Live counters of irqgen.ko in a read-only page that monitors
+ *          map through the sysfs "stats" attribute.
+ */
+
+# include <linux/kernel.h>           // Contains types, macros, functions for the kernel
+# include <linux/fs.h>               // Header for Linux file system support
+# include <linux/mm.h>               // struct vm_area_struct
+# include <linux/vmalloc.h>          // vmalloc_user/remap_vmalloc_range
+# include <linux/sysfs.h>
+
+# include "irqgen.h"                 // Shared module specific declarations
+
+static void stats_vfree(void *p)
+{
+    vfree(p);
+}
+
+// Must be called before requesting the IRQs: the handler updates the page
+int irqgen_stats_setup(struct platform_device *pdev)
+{
+    struct irqgen_stats_page *p;
+
+    BUILD_BUG_ON(sizeof(*p) > PAGE_SIZE);
+    if (irqgen_data->line_count > IRQGEN_STATS_MAX_LINES)
+        return -EINVAL;
+
+    p = vmalloc_user(PAGE_SIZE);
+    if (NULL == p) {
+        printk(KERN_ERR KMSG_PFX "Allocation of the stats page failed.\n");
+        return -ENOMEM;
+    }
+    p->magic = IRQGEN_STATS_MAGIC;
+    p->version = IRQGEN_STATS_VERSION;
+    p->line_count = irqgen_data->line_count;
+    irqgen_data->stats = p;
+
+    return devm_add_action_or_reset(&pdev->dev, stats_vfree, p);
+}
+
+// The "stats" attribute can also be read, for a one-off look at the page
+ssize_t irqgen_stats_read(struct file *f, struct kobject *kobj, struct bin_attribute *attr,
+                          char *buf, loff_t off, size_t count)
+{
+    return memory_read_from_buffer(buf, count, &off, irqgen_data->stats,
+                                   sizeof(*irqgen_data->stats));
+}
+
+// Monitors map the page read-only: the handler is its only writer
+int irqgen_stats_mmap(struct file *f, struct kobject *kobj, struct bin_attribute *attr,
+                      struct vm_area_struct *vma)
+{
+    if (vma->vm_flags & VM_WRITE)
+        return -EPERM;
+    vma->vm_flags &= ~VM_MAYWRITE;
+
+    return remap_vmalloc_range(vma, irqgen_data->stats, vma->vm_pgoff);
+}
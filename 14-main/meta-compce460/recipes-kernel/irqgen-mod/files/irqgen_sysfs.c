@@ -111,9 +111,18 @@ static ssize_t total_handled_show(struct device *dev, struct device_attribute *a
 }
 IRQGEN_ATTR_RO(total_handled);
 
+#ifdef IRQGEN_CONFIG_BATCHES
+// Generation batches: "<id> <line> <amount> <handled> <issued ns> <completion ns>"
+static ssize_t batches_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    return irqgen_batch_show(buf);
+}
+IRQGEN_ATTR_RO(batches);
+#endif
+
 static ssize_t enabled_show(struct device *dev, struct device_attribute *attr, char *buf)
 {
-    u32 regvalue = ioread32(IRQGEN_CTRL_REG);
+    u32 regvalue = irqgen_ioread32(IRQGEN_CTRL_REG);
     u8 val = FIELD_GET(IRQGEN_CTRL_REG_F_ENABLE, regvalue);
     return sprintf(buf, "%u\n", val);
 }
@@ -132,6 +141,119 @@ static ssize_t enabled_store(struct device *dev, struct device_attribute *attr,
 }
 IRQGEN_ATTR_RW(enabled);
 
+// Runtime switches: see irqgen_debug_key and irqgen_instr_key
+static ssize_t debug_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    return sprintf(buf, "%u\n", static_key_enabled(&irqgen_debug_key) ? 1 : 0);
+}
+static ssize_t debug_store(struct device *dev, struct device_attribute *attr, const char *buf, size_t count)
+{
+    bool var;
+    if (strtobool(buf, &var) < 0)
+        return -EINVAL;
+
+    if (var)
+        static_branch_enable(&irqgen_debug_key);
+    else
+        static_branch_disable(&irqgen_debug_key);
+
+    return count;
+}
+IRQGEN_ATTR_RW(debug);
+
+static ssize_t instrumentation_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    return sprintf(buf, "%u\n", static_key_enabled(&irqgen_instr_key) ? 1 : 0);
+}
+static ssize_t instrumentation_store(struct device *dev, struct device_attribute *attr, const char *buf, size_t count)
+{
+    bool var;
+    if (strtobool(buf, &var) < 0)
+        return -EINVAL;
+
+    if (var)
+        static_branch_enable(&irqgen_instr_key);
+    else
+        static_branch_disable(&irqgen_instr_key);
+
+    return count;
+}
+IRQGEN_ATTR_RW(instrumentation);
+
+#ifdef IRQGEN_CONFIG_STATS
+// PMU counters around the handler: creates or releases the perf counters
+static ssize_t pmu_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    return sprintf(buf, "%u\n", irqgen_pmu_is_enabled() ? 1 : 0);
+}
+static ssize_t pmu_store(struct device *dev, struct device_attribute *attr, const char *buf, size_t count)
+{
+    bool var;
+    int retval = 0;
+    if (strtobool(buf, &var) < 0)
+        return -EINVAL;
+
+    if (var)
+        retval = irqgen_pmu_enable();
+    else
+        irqgen_pmu_disable();
+    if (0 != retval)
+        return retval;
+
+    return count;
+}
+IRQGEN_ATTR_RW(pmu);
+
+// Affinity balancer: "<period ms> [<hysteresis %>]" starts it, "0" stops it
+static ssize_t balance_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    return irqgen_balance_show(buf);
+}
+static ssize_t balance_store(struct device *dev, struct device_attribute *attr, const char *buf, size_t count)
+{
+    unsigned int period, hysteresis = 20;
+    int retval;
+
+    if (sscanf(buf, "%u %u", &period, &hysteresis) < 1)
+        return -EINVAL;
+
+    retval = irqgen_balance_set(period, hysteresis);
+    if (0 != retval)
+        return retval;
+
+    return count;
+}
+IRQGEN_ATTR_RW(balance);
+#endif
+
+// Calibration: "run" measures again, "correct <0|1>" toggles the baseline
+// subtraction from the stored latencies, for the samples handled after it
+static ssize_t calib_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    return irqgen_calib_show(buf);
+}
+static ssize_t calib_store(struct device *dev, struct device_attribute *attr, const char *buf, size_t count)
+{
+    char cmd[8];
+    unsigned int correct = 0;
+    int retval = 0;
+
+    if (sscanf(buf, "%7s %u", cmd, &correct) < 1)
+        return -EINVAL;
+
+    if (0 == strcmp(cmd, "run"))
+        retval = irqgen_calib_run();
+    else if (0 == strcmp(cmd, "correct"))
+        irqgen_calib_set_correct(correct);
+    else
+        return -EINVAL;
+    if (0 != retval)
+        return retval;
+
+    return count;
+}
+IRQGEN_ATTR_RW(calib);
+
 static u8 line_store_buf = 0;
 static ssize_t line_store(struct device *dev, struct device_attribute *attr, const char *buf, size_t count)
 {
@@ -179,6 +301,232 @@ IRQGEN_ATTR_WO(line);
 IRQGEN_ATTR_WO(delay);
 IRQGEN_ATTR_WO(amount);
 
+// Ping-pong mode: "<line> <delay> <iterations>" starts a run, "stop" ends it
+static ssize_t pingpong_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    struct irqgen_pingpong pp;
+
+    spin_lock_irq(&irqgen_data->data_lock);
+    pp = irqgen_data->pingpong;
+    spin_unlock_irq(&irqgen_data->data_lock);
+
+    return sprintf(buf, "%u %u %u %u %u\n",
+                   pp.active, pp.line, pp.delay, pp.remaining, pp.completed);
+}
+static ssize_t pingpong_store(struct device *dev, struct device_attribute *attr, const char *buf, size_t count)
+{
+    unsigned int line, delay, iterations;
+    int retval;
+
+    if (sysfs_streq(buf, "stop")) {
+        irqgen_pingpong_stop();
+        return count;
+    }
+
+    if (sscanf(buf, "%u %u %u", &line, &delay, &iterations) != 3)
+        return -EINVAL;
+    if (line > IRQGEN_MAX_LINE || delay > IRQGEN_MAX_DELAY)
+        return -ERANGE;
+
+    retval = irqgen_pingpong_start(line, delay, iterations);
+    if (0 != retval)
+        return retval;
+
+    return count;
+}
+IRQGEN_ATTR_RW(pingpong);
+
+#ifdef IRQGEN_CONFIG_SAMPLES
+// Sample decimation: "<line> all", "<line> nth <N>", "<line> prob <ppm>" or
+// "<line> above <latency in clock cycles>"
+static ssize_t filter_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    return irqgen_filter_show(buf);
+}
+static ssize_t filter_store(struct device *dev, struct device_attribute *attr, const char *buf, size_t count)
+{
+    int line, retval;
+    char mode[8];
+    u32 param = 0;
+
+    if (sscanf(buf, "%d %7s %u", &line, mode, &param) < 2)
+        return -EINVAL;
+
+    retval = irqgen_filter_set(line, mode, param);
+    if (0 != retval)
+        return retval;
+
+    return count;
+}
+IRQGEN_ATTR_RW(filter);
+
+// Per-line channels: "<line> <size> [<fields>]" resizes the ring of a line,
+// a size of 0 disables it; fields is a mask of 1 << IRQGEN_FIELD_*, in hex
+// as it is read back
+static ssize_t channels_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    return irqgen_chan_show(buf);
+}
+static ssize_t channels_store(struct device *dev, struct device_attribute *attr, const char *buf, size_t count)
+{
+    char mask[16];
+    int line, n, retval;
+    u32 size, fields = 0;
+
+    n = sscanf(buf, "%d %u %15s", &line, &size, mask);
+    if (n < 2 || (3 == n && kstrtou32(mask, 16, &fields) < 0))
+        return -EINVAL;
+
+    retval = irqgen_chan_resize(line, size, fields);
+    if (0 != retval)
+        return retval;
+
+    return count;
+}
+IRQGEN_ATTR_RW(channels);
+
+// Whether the samples also go to the merged view of /dev/irqgen
+static ssize_t merged_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    return sprintf(buf, "%u\n", irqgen_data->merged);
+}
+static ssize_t merged_store(struct device *dev, struct device_attribute *attr, const char *buf, size_t count)
+{
+    struct irqgen_cmd resume;
+    bool var, issue;
+
+    if (strtobool(buf, &var) < 0)
+        return -EINVAL;
+
+    // Without the merged ring, its backlog no longer holds a pause
+    spin_lock_irq(&irqgen_data->data_lock);
+    irqgen_data->merged = var;
+    issue = irqgen_flowctl_resume(&resume, false);
+    spin_unlock_irq(&irqgen_data->data_lock);
+    if (issue) {
+        printk(KERN_INFO KMSG_PFX "Flow control resumed: merged ring disabled.\n");
+        irqgen_issue(&resume);
+    }
+
+    return count;
+}
+IRQGEN_ATTR_RW(merged);
+
+// Samples needed in the latencies buffer before waking up its readers
+static ssize_t wakeup_threshold_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    return sprintf(buf, "%u\n", irqgen_data->wakeup_threshold);
+}
+static ssize_t wakeup_threshold_store(struct device *dev, struct device_attribute *attr, const char *buf, size_t count)
+{
+    unsigned long val;
+    int retval = kstrtoul(buf, 10, &val);
+    if (0 != retval)
+        return retval;
+
+    if (val < 1 || val > MAX_LATENCIES - 1)
+        return -ERANGE;
+
+    spin_lock_irq(&irqgen_data->data_lock);
+    irqgen_data->wakeup_threshold = val;
+    spin_unlock_irq(&irqgen_data->data_lock);
+
+    return count;
+}
+IRQGEN_ATTR_RW(wakeup_threshold);
+
+// Flow control: "<high> <low>" watermarks in samples, or "off"
+static ssize_t flowctl_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    return irqgen_flowctl_show(buf);
+}
+static ssize_t flowctl_store(struct device *dev, struct device_attribute *attr, const char *buf, size_t count)
+{
+    int retval;
+    u32 high, low;
+
+    if (sysfs_streq(buf, "off"))
+        high = low = 0;
+    else if (sscanf(buf, "%u %u", &high, &low) != 2 || 0 == high)
+        return -EINVAL;
+
+    retval = irqgen_flowctl_set(high, low);
+    if (0 != retval)
+        return retval;
+
+    return count;
+}
+IRQGEN_ATTR_RW(flowctl);
+
+// Trigger: "manual", "latency <clock cycles>", "loss", "fire" or "off"
+static ssize_t trigger_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    return irqgen_trigger_show(buf);
+}
+static ssize_t trigger_store(struct device *dev, struct device_attribute *attr, const char *buf, size_t count)
+{
+    int retval;
+    char cmd[8];
+    u32 param = 0;
+
+    if (sscanf(buf, "%7s %u", cmd, &param) < 1)
+        return -EINVAL;
+
+    retval = irqgen_trigger_set(cmd, param);
+    if (0 != retval)
+        return retval;
+
+    return count;
+}
+IRQGEN_ATTR_RW(trigger);
+
+static ssize_t trigger_post_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    return sprintf(buf, "%u\n", irqgen_data->trigger.post);
+}
+static ssize_t trigger_post_store(struct device *dev, struct device_attribute *attr, const char *buf, size_t count)
+{
+    unsigned long val;
+    int retval = kstrtoul(buf, 10, &val);
+    if (0 != retval)
+        return retval;
+
+    retval = irqgen_trigger_set_post(val);
+    if (0 != retval)
+        return retval;
+
+    return count;
+}
+IRQGEN_ATTR_RW(trigger_post);
+
+// Measurement session: "start [<latency us> [pin]]" or "stop"
+static ssize_t session_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    return irqgen_session_show(buf);
+}
+static ssize_t session_store(struct device *dev, struct device_attribute *attr, const char *buf, size_t count)
+{
+    char cmd[8], pin[8] = "";
+    int latency_us = 0;
+    int retval = 0;
+
+    if (sscanf(buf, "%7s %d %7s", cmd, &latency_us, pin) < 1)
+        return -EINVAL;
+
+    if (0 == strcmp(cmd, "start"))
+        retval = irqgen_session_start(latency_us, 0 == strcmp(pin, "pin"), NULL);
+    else if (0 == strcmp(cmd, "stop"))
+        irqgen_session_stop(NULL);
+    else
+        return -EINVAL;
+    if (0 != retval)
+        return retval;
+
+    return count;
+}
+IRQGEN_ATTR_RW(session);
+#endif
+
 
 /*
  * Create a group of attributes so that we can create and destroy them all
@@ -186,10 +534,31 @@ IRQGEN_ATTR_WO(amount);
  */
 struct attribute *irqgen_attrs[] = {
     &IRQGEN_ATTR_GET_NAME(enabled).attr,
+    &IRQGEN_ATTR_GET_NAME(debug).attr,
+    &IRQGEN_ATTR_GET_NAME(instrumentation).attr,
+#ifdef IRQGEN_CONFIG_STATS
+    &IRQGEN_ATTR_GET_NAME(pmu).attr,
+    &IRQGEN_ATTR_GET_NAME(balance).attr,
+#endif
+    &IRQGEN_ATTR_GET_NAME(calib).attr,
     &IRQGEN_ATTR_GET_NAME(line).attr,
     &IRQGEN_ATTR_GET_NAME(delay).attr,
     &IRQGEN_ATTR_GET_NAME(amount).attr,
+    &IRQGEN_ATTR_GET_NAME(pingpong).attr,
+#ifdef IRQGEN_CONFIG_SAMPLES
+    &IRQGEN_ATTR_GET_NAME(filter).attr,
+    &IRQGEN_ATTR_GET_NAME(channels).attr,
+    &IRQGEN_ATTR_GET_NAME(merged).attr,
+    &IRQGEN_ATTR_GET_NAME(wakeup_threshold).attr,
+    &IRQGEN_ATTR_GET_NAME(flowctl).attr,
+    &IRQGEN_ATTR_GET_NAME(trigger).attr,
+    &IRQGEN_ATTR_GET_NAME(trigger_post).attr,
+    &IRQGEN_ATTR_GET_NAME(session).attr,
+#endif
     &IRQGEN_ATTR_GET_NAME(total_handled).attr,
+#ifdef IRQGEN_CONFIG_BATCHES
+    &IRQGEN_ATTR_GET_NAME(batches).attr,
+#endif
     &IRQGEN_ATTR_GET_NAME(latency).attr,
     &IRQGEN_ATTR_GET_NAME(count_register).attr,
     &IRQGEN_ATTR_GET_NAME(line_count).attr,
@@ -200,6 +569,23 @@ struct attribute *irqgen_attrs[] = {
     NULL,   /* need to NULL terminate the list of attributes */
 };
 
+#ifdef IRQGEN_CONFIG_STATS
+// Read-only page of live counters, see struct irqgen_stats_page
+static struct bin_attribute bin_attr_stats = {
+    .attr = { .name = "stats", .mode = 0444 },
+    .size = PAGE_SIZE,
+    .read = irqgen_stats_read,
+    .mmap = irqgen_stats_mmap,
+};
+#endif
+
+static struct bin_attribute *irqgen_bin_attrs[] = {
+#ifdef IRQGEN_CONFIG_STATS
+    &bin_attr_stats,
+#endif
+    NULL,
+};
+
 /*
  * An unnamed attribute group will put all of the attributes directly in
  * the kobject directory.  If we specify a name, a subdirectory will be
@@ -209,6 +595,7 @@ struct attribute *irqgen_attrs[] = {
 static struct attribute_group irqgen_attr_group = {
     .name = DRIVER_NAME,
     .attrs = irqgen_attrs,
+    .bin_attrs = irqgen_bin_attrs,
 };
 
 static const struct attribute_group *irqgen_attr_groups[] = {
@@ -234,6 +621,12 @@ int irqgen_sysfs_setup(struct platform_device *pdev)
     return retval;
 }
 
+// Wake up the pollers of an attribute: may sleep
+void irqgen_sysfs_notify(const char *attr)
+{
+    sysfs_notify(PARENT_KOBJ, DRIVER_NAME, attr);
+}
+
 void irqgen_sysfs_cleanup(struct platform_device *pdev)
 {
     sysfs_remove_groups(PARENT_KOBJ, irqgen_attr_groups);
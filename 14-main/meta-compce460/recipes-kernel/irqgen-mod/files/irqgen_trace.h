@@ -0,0 +1,117 @@
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM irqgen
+
+#if !defined(__IRQGEN_TRACE_H) || defined(TRACE_HEADER_MULTI_READ)
+#define __IRQGEN_TRACE_H
+
+#include <linux/tracepoint.h>
+
+#include "irqgen_uapi.h"            // struct irqgen_sample
+
+/*
+ * Tracepoints of the IRQ Generator module, available under
+ * /sys/kernel/tracing/events/irqgen/
+ */
+
+/* A generation command was written to the IRQ Generator */
+TRACE_EVENT(irqgen_generate,
+
+    TP_PROTO(u16 amount, u8 line, u16 delay, u32 batch),
+
+    TP_ARGS(amount, line, delay, batch),
+
+    TP_STRUCT__entry(
+        __field(u16, amount)
+        __field(u8, line)
+        __field(u16, delay)
+        __field(u32, batch)
+    ),
+
+    TP_fast_assign(
+        __entry->amount = amount;
+        __entry->line = line;
+        __entry->delay = delay;
+        __entry->batch = batch;
+    ),
+
+    TP_printk("amount=%u line=%u delay=%u batch=%u",
+              __entry->amount, __entry->line, __entry->delay, __entry->batch)
+);
+
+/*
+ * An IRQ was handled: the attach point of BPF programs running on each
+ * sample. The argument is the struct of irqgen_uapi.h, which is stable:
+ * raw tracepoint programs read it directly, and the format of the
+ * tracepoint mirrors its fields. `kept` tells whether the sample went past
+ * the filter into the latency buffer.
+ */
+TRACE_EVENT(irqgen_sample,
+
+    TP_PROTO(const struct irqgen_sample *s, bool kept),
+
+    TP_ARGS(s, kept),
+
+    TP_STRUCT__entry(
+        __field(u64, timestamp)
+        __field(u32, latency)
+        __field(u8, line)
+        __field(u8, cpu)
+        __field(u8, flags)
+        __field(u32, batch)
+        __field(u32, idx)
+        __field(bool, kept)
+    ),
+
+    TP_fast_assign(
+        __entry->timestamp = s->timestamp;
+        __entry->latency = s->latency;
+        __entry->line = s->line;
+        __entry->cpu = s->cpu;
+        __entry->flags = s->flags;
+        __entry->batch = s->batch;
+        __entry->idx = s->idx;
+        __entry->kept = kept;
+    ),
+
+    TP_printk("line=%u cpu=%u latency=%u timestamp=%llu batch=%u idx=%u flags=0x%x kept=%d",
+              __entry->line, __entry->cpu, __entry->latency, __entry->timestamp,
+              __entry->batch, __entry->idx, __entry->flags, __entry->kept)
+);
+
+/* The affinity balancer moved an IRQ line to another CPU */
+TRACE_EVENT(irqgen_migrate,
+
+    TP_PROTO(u8 line, unsigned int irq, int from, int to, u32 p99_from, u32 p99_to),
+
+    TP_ARGS(line, irq, from, to, p99_from, p99_to),
+
+    TP_STRUCT__entry(
+        __field(u8, line)
+        __field(unsigned int, irq)
+        __field(int, from)
+        __field(int, to)
+        __field(u32, p99_from)
+        __field(u32, p99_to)
+    ),
+
+    TP_fast_assign(
+        __entry->line = line;
+        __entry->irq = irq;
+        __entry->from = from;
+        __entry->to = to;
+        __entry->p99_from = p99_from;
+        __entry->p99_to = p99_to;
+    ),
+
+    TP_printk("line=%u irq=%u from=%d to=%d p99_from=%u p99_to=%u",
+              __entry->line, __entry->irq, __entry->from, __entry->to,
+              __entry->p99_from, __entry->p99_to)
+);
+
+#endif /* !defined(__IRQGEN_TRACE_H) || defined(TRACE_HEADER_MULTI_READ) */
+
+/* This part must be outside protection */
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#define TRACE_INCLUDE_FILE irqgen_trace
+#include <trace/define_trace.h>
@@ -0,0 +1,208 @@
+/**
+ * @file   irqgen_trigger.c
+ * @date   17 October 2026
+ * @target_device Xilinx PYNQ-Z1
+ * @brief   Oscilloscope-style trigger of irqgen.ko: freezes the latencies
+ *          buffer around a manual, latency or loss event.
+ */
+
+# include <linux/kernel.h>           // Contains types, macros, functions for the kernel
+# include <linux/fs.h>               // Header for Linux file system support
+# include <linux/string.h>
+# include <linux/vmalloc.h>          // vzalloc/vfree
+# include <linux/ktime.h>            // ktime_get_ns
+
+# include "irqgen.h"                 // Shared module specific declarations
+
+static const char * const irqgen_trigger_states[] = {
+    [IRQGEN_TRIGGER_IDLE]   = "idle",
+    [IRQGEN_TRIGGER_ARMED]  = "armed",
+    [IRQGEN_TRIGGER_FIRED]  = "fired",
+    [IRQGEN_TRIGGER_FROZEN] = "frozen",
+};
+
+static const char * const irqgen_trigger_conds[] = {
+    [IRQGEN_TRIGGER_MANUAL]  = "manual",
+    [IRQGEN_TRIGGER_LATENCY] = "latency",
+    [IRQGEN_TRIGGER_LOSS]    = "loss",
+};
+
+static void trigger_fire(struct irqgen_trigger *t, int pos, u64 timestamp)
+{
+    t->state = IRQGEN_TRIGGER_FIRED;
+    t->pos = pos;
+    t->timestamp = timestamp;
+    t->remaining = t->post;
+    if (0 == t->remaining)
+        t->state = IRQGEN_TRIGGER_FROZEN;
+}
+
+// Slow path of irqgen_trigger_keep(), for any state other than idle
+bool __irqgen_trigger_keep(u64 timestamp, u32 latency, bool keep)
+{
+    struct irqgen_trigger *t = &irqgen_data->trigger;
+    bool fire = false;
+
+    switch (t->state) {
+    case IRQGEN_TRIGGER_ARMED:
+        if (IRQGEN_TRIGGER_LATENCY == t->cond)
+            fire = (latency > t->threshold);
+        else if (IRQGEN_TRIGGER_LOSS == t->cond)
+            fire = keep && ((irqgen_data->wp + 1) % MAX_LATENCIES == irqgen_data->rp);
+        if (!fire)
+            return keep;
+        // The trigger sample goes in even if the filter would drop it
+        trigger_fire(t, irqgen_data->wp, timestamp);
+        return true;
+    case IRQGEN_TRIGGER_FIRED:
+        if (keep && 0 == --t->remaining)
+            t->state = IRQGEN_TRIGGER_FROZEN;
+        return keep;
+    case IRQGEN_TRIGGER_FROZEN:
+        if (keep)
+            ++t->frozen_drops;
+        return false;
+    }
+
+    return keep;
+}
+
+// Arm ("manual", "latency" with a threshold, "loss"), fire ("fire") or
+// disarm ("off") the trigger
+int irqgen_trigger_set(const char *cmd, u32 param)
+{
+    struct irqgen_trigger *t = &irqgen_data->trigger;
+    int retval = 0;
+    int c;
+
+    spin_lock_irq(&irqgen_data->data_lock);
+    if (0 == strcmp(cmd, "off")) {
+        t->state = IRQGEN_TRIGGER_IDLE;
+        ++t->gen;
+    } else if (0 == strcmp(cmd, "fire")) {
+        // The trigger sample is the last one stored: there must be one
+        if (IRQGEN_TRIGGER_ARMED != t->state)
+            retval = -EINVAL;
+        else if (!irqgen_data->wrapped && 0 == irqgen_data->wp)
+            retval = -EAGAIN;
+        else
+            trigger_fire(t, (irqgen_data->wp + MAX_LATENCIES - 1) % MAX_LATENCIES,
+                         ktime_get_ns());
+    } else {
+        for (c = 0; c < ARRAY_SIZE(irqgen_trigger_conds); ++c)
+            if (0 == strcmp(cmd, irqgen_trigger_conds[c]))
+                break;
+        if (c < ARRAY_SIZE(irqgen_trigger_conds)) {
+            t->state = IRQGEN_TRIGGER_ARMED;
+            t->cond = c;
+            t->threshold = param;
+            t->frozen_drops = 0;
+            ++t->gen;
+        } else {
+            retval = -EINVAL;
+        }
+    }
+    spin_unlock_irq(&irqgen_data->data_lock);
+
+    return retval;
+}
+
+// Set how many samples are recorded after the trigger sample: the rest of
+// the latency buffer holds the pre-trigger window
+int irqgen_trigger_set_post(u32 post)
+{
+    if (post > MAX_LATENCIES - 2)
+        return -ERANGE;
+
+    spin_lock_irq(&irqgen_data->data_lock);
+    irqgen_data->trigger.post = post;
+    spin_unlock_irq(&irqgen_data->data_lock);
+
+    return 0;
+}
+
+// "<state> <cond> <threshold> <post> <frozen_drops>"
+ssize_t irqgen_trigger_show(char *buf)
+{
+    struct irqgen_trigger t;
+
+    spin_lock_irq(&irqgen_data->data_lock);
+    t = irqgen_data->trigger;
+    spin_unlock_irq(&irqgen_data->data_lock);
+
+    return sprintf(buf, "%s %s %u %u %u\n",
+                   irqgen_trigger_states[t.state], irqgen_trigger_conds[t.cond],
+                   t.threshold, t.post, t.frozen_drops);
+}
+
+/*
+ * The "capture" debugfs file: the frozen latency buffer, oldest sample
+ * first. The handler leaves the buffer alone while frozen, so it is copied
+ * without holding the lock and the copy is discarded if the trigger was
+ * re-armed or disarmed meanwhile.
+ */
+static int irqgen_capture_open(struct inode *inode, struct file *f)
+{
+    struct irqgen_snapshot *snap;
+    struct irqgen_capture_hdr *hdr;
+    struct irqgen_sample *rec;
+    struct irqgen_trigger t;
+    int wp, first, count, i;
+    bool stale;
+
+    spin_lock_irq(&irqgen_data->data_lock);
+    t = irqgen_data->trigger;
+    wp = irqgen_data->wp;
+    count = irqgen_data->wrapped ? MAX_LATENCIES : wp;
+    spin_unlock_irq(&irqgen_data->data_lock);
+
+    if (IRQGEN_TRIGGER_FROZEN != t.state || 0 == count)
+        return -ENODATA;
+
+    snap = irqgen_snapshot_alloc(sizeof(*hdr) + count * sizeof(*rec));
+    if (NULL == snap)
+        return -ENOMEM;
+    hdr = (struct irqgen_capture_hdr *)snap->data;
+    rec = (struct irqgen_sample *)(hdr + 1);
+
+    first = irqgen_data->wrapped ? wp : 0;
+    for (i = 0; i < count; ++i) {
+        const struct latency_data *s = &irqgen_data->latencies[(first + i) % MAX_LATENCIES];
+
+        rec[i].timestamp = s->timestamp;
+        rec[i].latency = s->latency;
+        rec[i].line = s->line;
+        rec[i].cpu = s->cpu;
+        rec[i].flags = s->flags;
+        rec[i].batch = latency_data_batch(s);
+        rec[i].idx = latency_data_idx(s);
+    }
+
+    spin_lock_irq(&irqgen_data->data_lock);
+    stale = (irqgen_data->trigger.gen != t.gen ||
+             IRQGEN_TRIGGER_FROZEN != irqgen_data->trigger.state);
+    spin_unlock_irq(&irqgen_data->data_lock);
+    if (stale) {
+        vfree(snap);
+        return -EAGAIN;
+    }
+
+    hdr->magic = IRQGEN_CAPTURE_MAGIC;
+    hdr->version = IRQGEN_CAPTURE_VERSION;
+    hdr->cond = t.cond;
+    hdr->count = count;
+    hdr->trigger = (t.pos - first + MAX_LATENCIES) % MAX_LATENCIES;
+    hdr->threshold = t.threshold;
+    hdr->trigger_ns = t.timestamp;
+
+    f->private_data = snap;
+    return 0;
+}
+
+const struct file_operations irqgen_capture_fops = {
+    .owner = THIS_MODULE,
+    .open = irqgen_capture_open,
+    .read = irqgen_snapshot_read,
+    .release = irqgen_snapshot_release,
+    .llseek = default_llseek,
+};
@@ -0,0 +1,377 @@
+#ifndef __IRQGEN_UAPI_H
+#define __IRQGEN_UAPI_H
+
+/*
+ * Binary interfaces of the IRQ Generator module shared with userspace.
+ * Only fixed-size types from <linux/types.h> may be used in this file.
+ */
+
+#include <linux/types.h>
+#include <linux/ioctl.h>
+
+/* --- debugfs "rollups": ring of time-windowed rollups --- */
+# define IRQGEN_ROLLUP_MAGIC   0x49524752  /* "IRGR" */
+# define IRQGEN_ROLLUP_VERSION 1
+# define IRQGEN_ROLLUP_BINS    16
+
+/*-
+ * Header of the "rollups" debugfs file
+ *
+ * @magic: IRQGEN_ROLLUP_MAGIC
+ * @version: IRQGEN_ROLLUP_VERSION
+ * @bins: number of latency histogram bins in each record
+ * @line_count: number of IRQ lines covered by each window
+ * @count: number of struct irqgen_rollup_rec following the header
+ * @now_ns: timestamp in ns when the snapshot was taken
+ */
+struct irqgen_rollup_hdr {
+    __u32 magic;
+    __u16 version;
+    __u16 bins;
+    __u32 line_count;
+    __u32 count;
+    __u64 now_ns;
+};
+
+/*-
+ * One time window of one IRQ line
+ *
+ * Records are grouped by window width (narrowest first), then ordered from
+ * the oldest to the current window, then by line.
+ *
+ * @start_ns: timestamp in ns of the beginning of the window
+ * @width_ns: width of the window in ns
+ * @line: which interrupt line the record refers to
+ * @handled: IRQs handled on the line during the window
+ * @dropped: samples of the line evicted unread from the latency buffer
+ * @lat_min: minimum latency in clock cycles (0 if nothing was handled)
+ * @lat_max: maximum latency in clock cycles
+ * @lat_sum: sum of the latencies in clock cycles, for the mean
+ * @bins: log2 histogram of the latencies: bin i counts latencies in
+ *        [2^(i-1), 2^i) clock cycles, the last bin also counts anything
+ *        above
+ */
+struct irqgen_rollup_rec {
+    __u64 start_ns;
+    __u64 width_ns;
+    __u32 line;
+    __u32 handled;
+    __u32 dropped;
+    __u32 lat_min;
+    __u32 lat_max;
+    __u32 reserved;
+    __u64 lat_sum;
+    __u32 bins[IRQGEN_ROLLUP_BINS];
+};
+
+/*-
+ * One sample of the latency buffer
+ *
+ * @timestamp: timestamp in ns when the handler was started for this IRQ
+ * @latency: number of clock cycles reported by the FPGA module between
+ *           IRQ issue and acknowledgment
+ * @line: which interrupt line generated the IRQ
+ * @cpu: the CPU which handled the IRQ
+ * @batch: ID of the generation command which issued the IRQ (0 if unknown)
+ * @idx: index of the IRQ within its batch
+ * @flags: IRQGEN_SAMPLE_* flags
+ */
+# define IRQGEN_SAMPLE_SESSION  0x01    // handled during a measurement session
+# define IRQGEN_SAMPLE_CORRECTED 0x02   // calibration baseline subtracted
+
+struct irqgen_sample {
+    __u64 timestamp;
+    __u32 latency;
+    __u8  line;
+    __u8  cpu;
+    __u8  flags;
+    __u8  reserved;
+    __u32 batch;
+    __u32 idx;
+};
+
+/* --- debugfs "capture": latency buffer frozen by the trigger --- */
+# define IRQGEN_CAPTURE_MAGIC   0x49524743  /* "IRGC" */
+# define IRQGEN_CAPTURE_VERSION 2
+
+enum irqgen_trigger_cond {
+    IRQGEN_TRIGGER_MANUAL = 0,  // fired by writing "fire" to sysfs
+    IRQGEN_TRIGGER_LATENCY,     // a latency above the threshold
+    IRQGEN_TRIGGER_LOSS,        // an unread sample lost to an overflow
+};
+
+/*-
+ * Header of the "capture" debugfs file
+ *
+ * @magic: IRQGEN_CAPTURE_MAGIC
+ * @version: IRQGEN_CAPTURE_VERSION
+ * @cond: condition that fired the trigger, enum irqgen_trigger_cond
+ * @count: number of struct irqgen_sample following the header, oldest first
+ * @trigger: index among the samples of the trigger sample: the pre-trigger
+ *           window is [0, trigger), the post-trigger one (trigger, count)
+ * @threshold: latency threshold in clock cycles for IRQGEN_TRIGGER_LATENCY
+ * @trigger_ns: timestamp in ns when the trigger fired
+ */
+struct irqgen_capture_hdr {
+    __u32 magic;
+    __u16 version;
+    __u16 cond;
+    __u32 count;
+    __u32 trigger;
+    __u32 threshold;
+    __u32 reserved;
+    __u64 trigger_ns;
+};
+
+/* --- sysfs "stats": read-only page mmap'd by monitors --- */
+# define IRQGEN_STATS_MAGIC     0x49524753  /* "IRGS" */
+# define IRQGEN_STATS_VERSION   1
+# define IRQGEN_STATS_MAX_LINES 16          /* 4 bits of line in GENIRQ */
+
+/*-
+ * Counters of one IRQ line in the stats page
+ *
+ * @handled: IRQs handled on the line
+ * @dropped: samples of the line evicted unread from the latency buffer
+ * @last_latency: latency in clock cycles of the last IRQ handled
+ * @reserved: 0
+ * @last_ns: timestamp in ns when the handler was started for that IRQ
+ */
+struct irqgen_stats_line {
+    __u32 handled;
+    __u32 dropped;
+    __u32 last_latency;
+    __u32 reserved;
+    __u64 last_ns;
+};
+
+/*-
+ * The stats page, updated by the handler of each IRQ
+ *
+ * Readers take a consistent snapshot with the sequence counter: read @seq
+ * (acquire), retry while it is odd, copy the fields, then issue a read
+ * barrier and retry if @seq changed.
+ *
+ * @magic: IRQGEN_STATS_MAGIC
+ * @version: IRQGEN_STATS_VERSION
+ * @line_count: number of valid entries of @lines
+ * @seq: sequence counter, odd while an update is in progress
+ * @total_handled: IRQs handled on all the lines
+ * @dropped: samples evicted unread from the latency buffer
+ * @lines: per-line counters
+ */
+struct irqgen_stats_page {
+    __u32 magic;
+    __u16 version;
+    __u16 line_count;
+    __u32 seq;
+    __u32 total_handled;
+    __u32 dropped;
+    __u32 reserved;
+    struct irqgen_stats_line lines[IRQGEN_STATS_MAX_LINES];
+};
+
+/* --- /dev/irqgen ioctls --- */
+# define IRQGEN_IOC_MAGIC 'q'
+
+/*-
+ * A generation command (batch of IRQs on one line)
+ *
+ * @id: ID of the batch, as found in the samples
+ * @line: the IRQ line of the batch
+ * @amount: IRQs requested by the command
+ * @handled: IRQs of the batch handled
+ * @issued_ns: timestamp in ns when the command was written
+ * @done_ns: timestamp in ns when the last IRQ of the batch was handled
+ */
+struct irqgen_batch_info {
+    __u32 id;
+    __u32 line;
+    __u32 amount;
+    __u32 handled;
+    __u64 issued_ns;
+    __u64 done_ns;
+};
+
+/*
+ * Signal the given eventfd each time a batch completes, -1 to stop.
+ * Completions are also reported as EPOLLPRI by poll() on /dev/irqgen, until
+ * acknowledged by IRQGEN_IOC_GET_DONE.
+ */
+# define IRQGEN_IOC_SET_EVENTFD _IOW(IRQGEN_IOC_MAGIC, 1, __s32)
+/* Get the last completed batch (id 0 if none) */
+# define IRQGEN_IOC_GET_DONE    _IOR(IRQGEN_IOC_MAGIC, 2, struct irqgen_batch_info)
+/* Start consuming the submission queue, see IRQGEN_RING_NEED_WAKEUP */
+# define IRQGEN_IOC_RING_ENTER  _IO(IRQGEN_IOC_MAGIC, 3)
+
+/*-
+ * Start or stop a measurement session, see IRQGEN_SAMPLE_SESSION
+ *
+ * @flags: IRQGEN_SESSION_* flags, a session is stopped without
+ *         IRQGEN_SESSION_START
+ * @latency_us: the CPU latency and resume latency constraint, in us
+ */
+struct irqgen_session_req {
+    __u32 flags;
+    __s32 latency_us;
+};
+
+# define IRQGEN_SESSION_START     0x01
+# define IRQGEN_SESSION_PIN_FREQ  0x02  // hold the CPUs at their top frequency
+
+/* The session ends at the latest when the file is closed */
+# define IRQGEN_IOC_SESSION     _IOW(IRQGEN_IOC_MAGIC, 4, struct irqgen_session_req)
+
+/* --- /dev/irqgen mmap: submission and completion rings --- */
+# define IRQGEN_RING_SQ_ENTRIES 1024    /* power of 2 */
+# define IRQGEN_RING_CQ_ENTRIES 2048    /* power of 2 */
+
+/* irqgen_ring_hdr.flags: the kernel stopped consuming the submission
+ * queue, IRQGEN_IOC_RING_ENTER is needed after queueing more entries. The
+ * kernel may also stop with entries left, after looking at a queue worth
+ * of invalid ones: IRQGEN_IOC_RING_ENTER is always safe to issue. */
+# define IRQGEN_RING_NEED_WAKEUP (1U << 0)
+
+/*-
+ * Header at offset 0 of the mapping of /dev/irqgen
+ *
+ * The submission queue is written by userspace at sq_tail and consumed by
+ * the kernel at sq_head, one command at a time: the next one is written to
+ * the IRQ Generator when the batch of the previous one completes. The
+ * completion queue is written by the kernel at cq_tail and consumed by
+ * userspace at cq_head. Indexes are free running, masked with the number
+ * of entries - 1. Each side updates its index with release semantics and
+ * reads the other's with acquire semantics; after updating sq_tail,
+ * userspace needs a full barrier before checking flags.
+ *
+ * @sq_head: written by the kernel
+ * @sq_tail: written by userspace
+ * @sq_entries: IRQGEN_RING_SQ_ENTRIES
+ * @sq_off: offset in bytes of the struct irqgen_sqe array
+ * @cq_head: written by userspace
+ * @cq_tail: written by the kernel
+ * @cq_entries: IRQGEN_RING_CQ_ENTRIES
+ * @cq_off: offset in bytes of the struct irqgen_cqe array
+ * @flags: IRQGEN_RING_* flags, written by the kernel
+ * @cq_overflow: completions lost because the completion queue was full
+ */
+struct irqgen_ring_hdr {
+    __u32 sq_head;
+    __u32 sq_tail;
+    __u32 sq_entries;
+    __u32 sq_off;
+    __u32 cq_head;
+    __u32 cq_tail;
+    __u32 cq_entries;
+    __u32 cq_off;
+    __u32 flags;
+    __u32 cq_overflow;
+    __u32 reserved[6];
+};
+
+/* irqgen_sqe.flags: post no completion for this command */
+# define IRQGEN_SQE_SKIP_CQE (1U << 0)
+
+/*-
+ * A generation command in the submission queue
+ *
+ * @user_data: copied to the completion
+ * @amount: IRQs to generate, at least 1
+ * @delay: IRQ delay
+ * @line: the IRQ line to use
+ * @flags: IRQGEN_SQE_* flags
+ */
+struct irqgen_sqe {
+    __u64 user_data;
+    __u16 amount;
+    __u16 delay;
+    __u8  line;
+    __u8  flags;
+    __u16 reserved;
+};
+
+/*-
+ * A completion in the completion queue
+ *
+ * @user_data: from the submission
+ * @batch: ID of the batch of the command, 0 if it was rejected
+ * @res: 0 if all the IRQs were handled, -EINVAL if the submission was
+ *       rejected, -ECANCELED if the batch was superseded by another
+ *       command on its line or the IRQ Generator was disabled
+ * @issued_ns: timestamp in ns when the command was written
+ * @done_ns: timestamp in ns when the last IRQ was handled
+ */
+struct irqgen_cqe {
+    __u64 user_data;
+    __u32 batch;
+    __s32 res;
+    __u64 issued_ns;
+    __u64 done_ns;
+};
+
+/* --- /dev/irqgen-line<N>: binary records of the per-line channels --- */
+# define IRQGEN_SCHEMA_MAGIC   0x53515249  /* "IRQS" */
+# define IRQGEN_SCHEMA_VERSION 1
+
+/*
+ * Fields of a record, as bit numbers of irqgen_schema.fields: only the
+ * fields enabled for a channel are stored in its ring, in this order, each
+ * at its natural alignment. New fields are only ever appended, so that a
+ * reader looking up the offsets in the header keeps working. PUBLISH needs
+ * a module built with IRQGEN_STATS, BATCH and IDX one with IRQGEN_BATCHES:
+ * without, selecting them fails with EOPNOTSUPP and they are left out of
+ * the default fields.
+ */
+# define IRQGEN_FIELD_TIMESTAMP 0   /* __u64, see irqgen_sample */
+# define IRQGEN_FIELD_LATENCY   1   /* __u32 */
+# define IRQGEN_FIELD_PUBLISH   2   /* __u32, ns until the sample was visible */
+# define IRQGEN_FIELD_BATCH     3   /* __u32 */
+# define IRQGEN_FIELD_IDX       4   /* __u32 */
+# define IRQGEN_FIELD_SEQ       5   /* __u32, sequence number in the channel */
+# define IRQGEN_FIELD_LINE      6   /* __u8 */
+# define IRQGEN_FIELD_CPU       7   /* __u8 */
+# define IRQGEN_FIELD_FLAGS     8   /* __u8 */
+# define IRQGEN_FIELD_COUNT     9
+# define IRQGEN_FIELD_MAX       16  /* room in irqgen_schema.layout */
+
+# define IRQGEN_FIELDS_ALL      ((1U << IRQGEN_FIELD_COUNT) - 1)
+/* The fields of the CSV lines of /dev/irqgen */
+# define IRQGEN_FIELDS_DEFAULT  ((1U << IRQGEN_FIELD_TIMESTAMP) | (1U << IRQGEN_FIELD_LATENCY) | \
+                                 (1U << IRQGEN_FIELD_BATCH) | (1U << IRQGEN_FIELD_IDX) |         \
+                                 (1U << IRQGEN_FIELD_LINE) | (1U << IRQGEN_FIELD_CPU) |          \
+                                 (1U << IRQGEN_FIELD_FLAGS))
+
+/*-
+ * Place of a field in a record
+ *
+ * @offset: offset in bytes from the start of the record
+ * @size: size in bytes, 0 if the field is not in the records
+ */
+struct irqgen_schema_field {
+    __u8 offset;
+    __u8 size;
+};
+
+/*-
+ * Header of the binary stream of a channel, returned by the first read()
+ * after IRQGEN_IOC_CHAN_BINARY; the next reads return whole records
+ *
+ * @magic: IRQGEN_SCHEMA_MAGIC
+ * @version: IRQGEN_SCHEMA_VERSION
+ * @stride: size in bytes of a record
+ * @fields: mask of the fields in the records, 1 << IRQGEN_FIELD_*
+ * @layout: place of each field, indexed by IRQGEN_FIELD_*
+ */
+struct irqgen_schema {
+    __u32 magic;
+    __u16 version;
+    __u16 stride;
+    __u32 fields;
+    __u32 reserved;
+    struct irqgen_schema_field layout[IRQGEN_FIELD_MAX];
+};
+
+/* Switch an open channel node from CSV lines to binary records */
+# define IRQGEN_IOC_CHAN_BINARY _IO(IRQGEN_IOC_MAGIC, 5)
+
+#endif /* !defined(__IRQGEN_UAPI_H) */
@@ -0,0 +1,183 @@
+/**
+ * @file   irqgen_uio.c
+ * @date   17 October 2026
+ * @target_device Xilinx PYNQ-Z1
+ * @brief   UIO binding of the IRQ Generator IP block, for the userspace
+ *          driver of recipes-apps/irqgen-uio.
+ *
+ * Alternative to irqgen.ko, binding the same "wapice,irq-gen" node: only one
+ * of the two modules can be loaded at a time. Each IRQ line is exported as
+ * a /dev/uioN device named "irqgen-line<idx>", all of them mapping the
+ * register space as map 0. The handler only masks the IRQ: the userspace
+ * driver acknowledges it in the registers, then writes 1 to the device to
+ * unmask it.
+ */
+
+#include <linux/init.h>             // Macros used to mark up functions e.g., __init __ex
+#include <linux/module.h>           // Core header for loading LKMs into the kern
+#include <linux/kernel.h>           // Contains types, macros, functions for the kernel
+#include <linux/platform_device.h>  // Platform device related functions
+#include <linux/of.h>               // Property reads from device tree
+#include <linux/interrupt.h>        // Interrupt handling functions
+#include <linux/slab.h>             // Kernel slab allocator
+#include <linux/uio_driver.h>       // Userspace I/O drivers
+
+#define DRIVER_NAME "irqgen_uio"
+#define KMSG_PFX "IRQGEN-UIO: "
+
+#define PROP_COMPATIBLE "wapice,irq-gen"
+
+/*-
+ * Structure for one exported IRQ line
+ *
+ * @info: the UIO device of the line
+ * @name: "irqgen-line<idx>"
+ * @masked: whether the IRQ is masked, protected by @lock
+ * @lock: serializes the handler and irqcontrol()
+ */
+struct irqgen_uio_line {
+    struct uio_info info;
+    char name[16];
+    bool masked;
+    spinlock_t lock;
+};
+
+struct irqgen_uio {
+    int line_count;
+    struct irqgen_uio_line *lines;
+};
+
+// Mask the IRQ until userspace has acknowledged it
+static irqreturn_t irqgen_uio_handler(int irq, struct uio_info *info)
+{
+    struct irqgen_uio_line *l = info->priv;
+
+    spin_lock(&l->lock);
+    if (!l->masked) {
+        disable_irq_nosync(irq);
+        l->masked = true;
+    }
+    spin_unlock(&l->lock);
+
+    return IRQ_HANDLED;
+}
+
+// write() of 1 to /dev/uioN unmasks the IRQ, 0 masks it
+static int irqgen_uio_irqcontrol(struct uio_info *info, s32 on)
+{
+    struct irqgen_uio_line *l = info->priv;
+    unsigned long flags;
+
+    spin_lock_irqsave(&l->lock, flags);
+    if (on && l->masked) {
+        enable_irq(info->irq);
+        l->masked = false;
+    } else if (!on && !l->masked) {
+        disable_irq_nosync(info->irq);
+        l->masked = true;
+    }
+    spin_unlock_irqrestore(&l->lock, flags);
+
+    return 0;
+}
+
+static int irqgen_uio_probe(struct platform_device *pdev)
+{
+    struct irqgen_uio *u;
+    struct resource *iomem_range;
+    int i, retval;
+
+    u = devm_kzalloc(&pdev->dev, sizeof(*u), GFP_KERNEL);
+    if (NULL == u)
+        return -ENOMEM;
+
+    iomem_range = platform_get_resource(pdev, IORESOURCE_MEM, 0);
+    if (NULL == iomem_range) {
+        printk(KERN_ERR KMSG_PFX "platform_get_resource(IORESOURCE_MEM) failed.\n");
+        return -ENODEV;
+    }
+
+    u->line_count = platform_irq_count(pdev);
+    if (u->line_count <= 0) {
+        printk(KERN_ERR KMSG_PFX "No IRQ ID entries found for the device.\n");
+        return -ENODEV;
+    }
+
+    u->lines = devm_kcalloc(&pdev->dev, u->line_count, sizeof(*u->lines), GFP_KERNEL);
+    if (NULL == u->lines)
+        return -ENOMEM;
+
+    for (i = 0; i < u->line_count; ++i) {
+        struct irqgen_uio_line *l = &u->lines[i];
+        int irq_id = platform_get_irq(pdev, i);
+
+        if (irq_id < 0) {
+            printk(KERN_ERR KMSG_PFX
+                   "Invalid IRQ ID entry for the device at index %d.\n", i);
+            retval = irq_id;
+            goto err;
+        }
+
+        spin_lock_init(&l->lock);
+        snprintf(l->name, sizeof(l->name), "irqgen-line%d", i);
+        l->info.name = l->name;
+        l->info.version = "0.7";
+        l->info.irq = irq_id;
+        l->info.handler = irqgen_uio_handler;
+        l->info.irqcontrol = irqgen_uio_irqcontrol;
+        l->info.priv = l;
+
+        l->info.mem[0].name = "registers";
+        l->info.mem[0].addr = iomem_range->start;
+        l->info.mem[0].size = resource_size(iomem_range);
+        l->info.mem[0].memtype = UIO_MEM_PHYS;
+
+        retval = uio_register_device(&pdev->dev, &l->info);
+        if (0 != retval) {
+            printk(KERN_ERR KMSG_PFX "uio_register_device() failed for line %d.\n", i);
+            goto err;
+        }
+    }
+
+    platform_set_drvdata(pdev, u);
+    printk(KERN_INFO KMSG_PFX "%d IRQ lines exported.\n", u->line_count);
+    return 0;
+
+ err:
+    while (--i >= 0)
+        uio_unregister_device(&u->lines[i].info);
+    return retval;
+}
+
+static int irqgen_uio_remove(struct platform_device *pdev)
+{
+    struct irqgen_uio *u = platform_get_drvdata(pdev);
+    int i;
+
+    for (i = 0; i < u->line_count; ++i)
+        uio_unregister_device(&u->lines[i].info);
+
+    return 0;
+}
+
+static const struct of_device_id irqgen_uio_of_ids[] = {
+    { .compatible = PROP_COMPATIBLE, },
+    { /* end of list */ }
+};
+MODULE_DEVICE_TABLE(of, irqgen_uio_of_ids);
+
+static struct platform_driver irqgen_uio_pdriver = {
+    .driver = {
+        .name = DRIVER_NAME,
+        .owner = THIS_MODULE,
+        .of_match_table = irqgen_uio_of_ids,
+    },
+    .probe = irqgen_uio_probe,
+    .remove = irqgen_uio_remove,
+};
+
+module_platform_driver(irqgen_uio_pdriver);
+
+MODULE_LICENSE("GPL");
+MODULE_DESCRIPTION("UIO binding of the IRQ Generator IP block for userspace drivers");
+MODULE_VERSION("0.7");